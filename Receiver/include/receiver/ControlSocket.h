@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace receiver {
+
+// Local control endpoint for a running bridge: a Unix stream socket taking one command per line,
+// e.g. from `socat - UNIX-CONNECT:<path>` or `nc -U <path>`. Nothing here blocks. The send loop
+// calls poll() once per tick and the handler runs on that thread, so commands can touch the
+// scheduler and vehicle table without locks. Each poll answers at most a few lines per client; the
+// rest wait for the next one. Replies are queued per client and written as the socket accepts
+// them. The socket file is created owner-only (0600).
+class ControlSocket {
+public:
+    // Returns the reply for one command line (without its newline), newline-terminated.
+    using Handler = std::function<std::string(const std::string& line)>;
+
+    // Replaces a stale socket left at `path` by an earlier run; refuses to remove anything else.
+    // Throws std::runtime_error if the socket cannot be bound.
+    explicit ControlSocket(const std::string& path);
+    // Disconnects every client and unlinks `path`.
+    ~ControlSocket();
+
+    ControlSocket(const ControlSocket&)            = delete;
+    ControlSocket& operator=(const ControlSocket&) = delete;
+
+    // Accepts waiting clients, reads what they sent and answers their complete lines, up to the
+    // per-poll limit.
+    void poll(const Handler& handler);
+
+    const std::string& path() const { return path_; }
+
+private:
+    struct Client {
+        int fd = -1;
+        std::string input;   // bytes after the last complete line
+        std::string output;  // reply bytes the socket has not taken yet
+    };
+
+    // False once the client is gone or misbehaving; the caller then closes it.
+    bool service(Client& client, const Handler& handler);
+    static bool flush(Client& client);
+
+    std::string path_;
+    int listen_fd_ = -1;
+    std::vector<Client> clients_;
+};
+
+}  // namespace receiver
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "receiver/TrackerClient.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace receiver {
+
+// World/body convention of the poses coming out of the mocap system.
+enum class MocapFrame {
+    kNone,  // forward poses untouched
+    kEnu,   // ENU world, FLU body (VRPN/ROS convention)
+    kYUp,   // Y-up world (Motive, Vicon Tracker), rigid body created facing north (-Z)
+};
+
+MocapFrame parse_mocap_frame(const std::string& name);
+
+// Parses "x,y,z" as used by the offset flags.
+std::array<double, 3> parse_vector3(const std::string& value);
+
+struct FrameTransformOptions {
+    MocapFrame frame      = MocapFrame::kNone;
+    double yaw_offset_rad = 0.0;  // heading of the mocap north axis relative to NED north
+    std::array<double, 3> origin_offset{};  // NED metres added after rotation
+    std::array<double, 3> body_offset{};    // FRD metres from the rigid-body pivot to the vehicle origin
+};
+
+// Structure-of-arrays pose batch. Slot i belongs to tracker i of a FrameTransformStage.
+struct PoseBatch {
+    void resize(size_t count);
+    size_t size() const { return x.size(); }
+    void set(size_t index, const Pose& pose);
+    Pose get(size_t index) const;
+
+    std::vector<double> timestamp_sec;
+    std::vector<double> x, y, z;
+    std::vector<double> qx, qy, qz, qw;
+    std::vector<double> roll, pitch, yaw;
+};
+
+// Mocap → NED/FRD conversion. Every rotation and offset of a tracker is folded into one position
+// matrix plus a pre/post quaternion pair when the tracker is added, so applying it is a handful of
+// multiply-adds per pose laid out for the compiler's auto-vectoriser.
+class FrameTransformStage {
+public:
+    size_t add_tracker(const FrameTransformOptions& options);
+    size_t size() const { return tx_.size(); }
+
+    // Transforms batch slot i with tracker i's coefficients; batch.size() must equal size().
+    void apply(PoseBatch& batch) const;
+    // Transforms only the listed slots and leaves every other slot as it is, for a send tick that
+    // refreshed just the vehicles due this tick. Cost follows slots.size(), not size().
+    void apply(PoseBatch& batch, const std::vector<size_t>& slots) const;
+
+private:
+    template <typename SlotOf>
+    void transform(PoseBatch& batch, size_t count, SlotOf slot_of) const;
+
+    // Row-major position rotation, one array per element so every coefficient stream is contiguous.
+    std::array<std::vector<double>, 9> rot_;
+    std::vector<double> tx_, ty_, tz_;
+    std::vector<double> pre_x_, pre_y_, pre_z_, pre_w_;
+    std::vector<double> post_x_, post_y_, post_z_, post_w_;
+    std::vector<double> body_x_, body_y_, body_z_;
+};
+
+}  // namespace receiver
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace receiver {
+
+struct VehicleShare {
+    double weight       = 1.0;
+    double requested_hz = 0.0;
+    double allocated_hz = 0.0;  // weighted max-min fair share of the link budget
+    uint64_t sent       = 0;  // accepted by the FC link
+    uint64_t dropped    = 0;  // acquired, but the FC link refused the frame (driver buffer full)
+    uint64_t deferred   = 0;  // slot was due but the link bucket had no room for the frame
+};
+
+// Splits one link's byte budget between several vehicles (one sysid each) sharing it.
+//
+// Allocation is weighted max-min fair: a vehicle asking for less than its weighted share gets its
+// full rate and the remainder is split among the others by weight. Each vehicle then sends from a
+// token bucket at its allocated rate, and every frame also draws its actual size from a link-wide
+// byte bucket holding at most ~10 ms of line time, so overload lowers rates instead of building a
+// queue in front of the radio.
+class LinkScheduler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // `link_bytes_per_s` <= 0 means unlimited: every vehicle gets its requested rate.
+    LinkScheduler(double link_bytes_per_s, double frame_bytes);
+
+    // Reuses the slot of a removed vehicle when there is one, so indices stay dense.
+    size_t add_vehicle(double requested_hz, double weight);
+    // Frees the slot; it gets no share and is never due until add_vehicle() reuses it.
+    void remove_vehicle(size_t index);
+    bool active(size_t index) const { return vehicles_[index].active; }
+    // Re-splits the budget; every bucket keeps its banked tokens, so the other vehicles' send
+    // phase is undisturbed.
+    void set_rate(size_t index, double requested_hz);
+    // A paused vehicle keeps its slot but gets no share, so a tracker that went stale does not
+    // hold link budget the others could use. Its bucket stops refilling until it is resumed.
+    void set_paused(size_t index, bool paused);
+    bool paused(size_t index) const { return vehicles_[index].paused; }
+    size_t size() const { return vehicles_.size(); }
+    const VehicleShare& vehicle(size_t index) const { return vehicles_[index].share; }
+
+    bool limited() const { return link_bytes_per_s_ > 0.0; }
+    double link_bytes_per_s() const { return link_bytes_per_s_; }
+    // Frames per second the link can carry at the current average frame size.
+    double capacity_hz() const;
+
+    // Refills every bucket up to `now`; call once per send tick.
+    void advance(clock::time_point now);
+
+    // True if `index` has a send slot, whether or not the link has room right now.
+    bool due(size_t index) const { return vehicles_[index].tokens >= 1.0; }
+    // Banked send slots; when the link is short, serve the vehicle furthest behind first.
+    double credit(size_t index) const { return vehicles_[index].tokens; }
+    // Claims a send slot for `index` and reserves an average frame on the link. False (and a
+    // deferral) when only the link is short.
+    bool acquire(size_t index);
+    // Settles an acquired slot with the `bytes` actually sent; 0 means the link dropped the frame.
+    // A drop still uses the slot and keeps the link reservation, since the link was already full,
+    // but is neither counted as sent nor folded into the average frame size.
+    void commit(size_t index, size_t bytes);
+
+private:
+    struct Vehicle {
+        VehicleShare share;
+        double tokens = 1.0;  // a fresh vehicle may send straight away
+        bool active   = true;
+        bool paused   = false;
+    };
+
+    void allocate();
+
+    std::vector<Vehicle> vehicles_;
+    double link_bytes_per_s_ = 0.0;
+    double frame_bytes_      = 0.0;  // running average of committed frame sizes
+    double allocated_bytes_  = 0.0;  // frame_bytes_ the current allocation was computed with
+    double link_tokens_      = 0.0;
+    clock::time_point last_advance_{};
+    bool started_ = false;
+};
+
+}  // namespace receiver
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "receiver/MavlinkSender.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <vector>
+
+namespace receiver {
+
+struct RelayStats {
+    uint64_t fc_frames      = 0;  // FC -> GCS, counted once however many endpoints got it
+    uint64_t fc_bytes       = 0;
+    uint64_t fc_crc_errors  = 0;
+    uint64_t fc_unknown     = 0;  // forwarded with an unchecked CRC: message id not in any vendored dialect
+    uint64_t gcs_frames     = 0;  // GCS -> FC
+    uint64_t gcs_crc_errors = 0;
+    uint64_t gcs_unknown    = 0;
+    uint64_t gcs_rejected   = 0;  // datagrams from an address:port that is not a --gcs endpoint
+    uint64_t send_errors    = 0;  // sendto a GCS endpoint failed (unreachable, socket buffer full)
+};
+
+// Telemetry path next to vision injection, replacing a separate MAVLink router: frames read from
+// the FC link are parsed incrementally and forwarded to every GCS endpoint straight out of the read
+// buffer, and frames the GCS sends back go to the FC through the same MavlinkSender (and so the
+// same pending-tail and drop rules as vision frames). Only frames with a valid CRC cross over, plus
+// frames whose message id no vendored dialect knows: their CRC cannot be checked here, so they are
+// passed on for the far end to check. Driven from the send loop, which calls service_until()
+// instead of sleeping between ticks.
+class MavlinkRelay {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // `gcs_endpoints` are host:port targets; `bind_port` is the local UDP port they reply to
+    // (0 picks an ephemeral one). Only datagrams sent from one of the endpoints are relayed to the
+    // FC. Throws std::runtime_error if the socket cannot be set up.
+    MavlinkRelay(MavlinkSender& fc_link, const std::vector<std::string>& gcs_endpoints, uint16_t bind_port);
+    ~MavlinkRelay();
+
+    MavlinkRelay(const MavlinkRelay&)            = delete;
+    MavlinkRelay& operator=(const MavlinkRelay&) = delete;
+
+    // Waits in poll() for traffic on either side until `deadline`, relaying whatever arrives. A side
+    // that hangs up or fails for good (e.g. an unplugged USB serial adapter) is not polled again.
+    void service_until(clock::time_point deadline);
+
+    uint16_t local_port() const { return local_port_; }
+    // True once that side was dropped from the poll set.
+    bool fc_lost() const { return fc_lost_; }
+    bool gcs_lost() const { return gcs_lost_; }
+    const RelayStats& stats() const { return stats_; }
+
+private:
+    struct FrameParser;
+
+    void read_fc();
+    void read_gcs();
+
+    MavlinkSender& fc_link_;
+    int gcs_socket_      = -1;
+    uint16_t local_port_ = 0;
+    std::vector<sockaddr_in> gcs_endpoints_;
+    std::unique_ptr<FrameParser> fc_parser_;
+    std::unique_ptr<FrameParser> gcs_parser_;
+    bool fc_lost_  = false;
+    bool gcs_lost_ = false;
+    RelayStats stats_{};
+};
+
+}  // namespace receiver
@@ -2,9 +2,12 @@
 
 #include "receiver/TrackerClient.h"
 
+#include <cstddef>
+#include <array>
 #include <cstdint>
 #include <netinet/in.h>
 #include <string>
+#include <vector>
 
 namespace receiver {
 
@@ -15,29 +18,91 @@ struct MavlinkOptions {
     std::string udp_target = "127.0.0.1:14550";
     uint8_t system_id = 1;
     uint8_t component_id = 1;
+    // Extra sinks receiving the same frames: "udp:<host>:<port>" or "serial:<device>:<baud>".
+    std::vector<std::string> mirrors;
 };
 
+// Upper bound of one serialised MAVLink frame (MAVLINK_MAX_PACKET_LEN), without pulling the
+// generated headers into every includer.
+constexpr size_t kMaxMavlinkFrameLength = 280;
+
+// "<ipv4>:<port>" to a socket address. Throws std::invalid_argument when malformed.
+sockaddr_in resolve_udp_endpoint(const std::string& host_port);
+
+// Packs `pose` as VISION_POSITION_ESTIMATE with MAVLink sequence number `sequence` into `buffer`
+// and returns the frame length. Touches no MAVLink channel state, so any thread may call it.
+uint16_t encode_vision_position_estimate(const Pose& pose, uint8_t system_id, uint8_t component_id, uint8_t* buffer,
+                                         uint8_t sequence = 0);
+
+// Writes are non-blocking. A frame the tty only partly accepted is finished before anything new is
+// written; a frame that cannot be queued at all is dropped rather than torn or blocked on.
+struct LinkStats {
+    uint64_t frames_sent    = 0;  // fully handed to the link (possibly finished on a later call)
+    uint64_t frames_dropped = 0;  // EAGAIN, or an earlier frame was still pending
+    uint64_t partial_writes = 0;
+    uint64_t bytes_written  = 0;
+};
+
+// Each frame is encoded once and handed to every sink in turn: the FC link first, then the
+// mirrors. Every sink has its own pending tail and stats, and a mirror never blocks or throws, so
+// a slow or dead mirror drops its own frames without delaying the FC.
 class MavlinkSender {
 public:
     explicit MavlinkSender(const MavlinkOptions& options);
     ~MavlinkSender();
 
-    void send_pose(const Pose& pose);
+    // Returns the frame length, or 0 if the FC link dropped the frame (mirrors do not count). A
+    // partly written frame counts as sent: its tail goes out before anything else.
+    uint16_t send_pose(const Pose& pose) { return send_pose(pose, system_id_); }
+    // Sends on behalf of `system_id`, for several vehicles sharing one link. Each system id keeps
+    // its own MAVLink sequence so the FC's per-system loss accounting stays meaningful.
+    uint16_t send_pose(const Pose& pose, uint8_t system_id);
+
+    // Writes an already serialised frame (e.g. relayed from a GCS) to the FC link only, under the
+    // same rules as poses.
+    void send_frame(const uint8_t* data, size_t length) { write_sink(link_, data, length); }
+
+    // Retries the unwritten tails of partially written frames on every sink. Returns true once
+    // nothing is pending anywhere.
+    bool flush_pending();
+    const LinkStats& link_stats() const { return link_.stats; }
+
+    size_t mirror_count() const { return mirrors_.size(); }
+    const std::string& mirror_name(size_t index) const { return mirrors_[index].name; }
+    const LinkStats& mirror_stats(size_t index) const { return mirrors_[index].stats; }
+
+    // The FC side of the link, for polling: the serial fd, or the UDP socket the FC answers to.
+    int link_fd() const { return link_.fd; }
+    // Non-blocking read of whatever the FC sent; 0 when nothing is waiting.
+    size_t read_link(uint8_t* buffer, size_t capacity);
 
 private:
-    void open_serial(const std::string& device, int baud_rate);
-    void open_udp(const std::string& target);
+    struct Sink {
+        std::string name;
+        bool mirror = false;  // errors count as drops instead of throwing
+        bool udp    = false;
+        int fd      = -1;  // serial device or UDP socket
+        sockaddr_in address{};
+        std::vector<uint8_t> pending;  // unwritten tail of a serial frame
+        LinkStats stats{};
+    };
+
+    static Sink open_serial(const std::string& device, int baud_rate);
+    static Sink open_udp(const std::string& target);
+    static Sink open_mirror(const std::string& spec);
 
-    void write_bytes(const uint8_t* data, size_t length);
+    // Each returns whether the (FC) sink took the frame, false if it was dropped.
+    bool write_bytes(const uint8_t* data, size_t length);
+    bool write_sink(Sink& sink, const uint8_t* data, size_t length);
+    bool write_serial(Sink& sink, const uint8_t* data, size_t length);
+    bool flush_sink(Sink& sink);
 
-    int fd_ = -1;
-    bool use_udp_ = false;
     uint8_t system_id_ = 1;
     uint8_t component_id_ = 1;
+    std::array<uint8_t, 256> tx_sequence_{};
 
-    // UDP specifics
-    int udp_socket_ = -1;
-    struct sockaddr_in udp_addr_{};
+    Sink link_;  // the flight controller
+    std::vector<Sink> mirrors_;
 };
 
 }  // namespace receiver
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <vrpn_Tracker.h>
+
+namespace receiver {
+
+// On-disk record: one raw vrpn_TRACKERCB plus the local arrival time. Fixed width and 8-byte
+// aligned so a memory-mapped capture can be indexed directly. Host byte order.
+struct CaptureRecord {
+    int64_t arrival_us = 0;  // local system clock when the callback fired
+    int64_t msg_sec    = 0;
+    int64_t msg_usec   = 0;
+    int32_t sensor     = 0;
+    int32_t reserved   = 0;
+    double pos[3]      = {0.0, 0.0, 0.0};
+    double quat[4]     = {0.0, 0.0, 0.0, 1.0};
+};
+static_assert(sizeof(CaptureRecord) == 88, "CaptureRecord layout is part of the file format");
+
+// Microseconds since the Unix epoch, the same clock VRPN stamps msg_time with.
+int64_t capture_clock_us();
+
+vrpn_TRACKERCB to_tracker_cb(const CaptureRecord& record);
+
+// Records carry no tracker identity, so one file holds one tracker's reports.
+class CaptureWriter {
+public:
+    // Creates `path`; throws std::runtime_error if it already exists rather than overwriting it.
+    explicit CaptureWriter(const std::string& path);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&)            = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // Called from the VRPN callback, so it never throws: the first failed write (e.g. a full disk)
+    // disables the writer and every later report is only counted in dropped().
+    void append(const vrpn_TRACKERCB& info, int64_t arrival_us);
+    void flush();
+    uint64_t records() const { return records_; }
+    uint64_t dropped() const { return dropped_; }
+    // Safe to poll from another thread; error() is set before failed() turns true.
+    bool failed() const { return failed_.load(std::memory_order_acquire); }
+    const std::string& error() const { return error_; }
+
+private:
+    void fail(const char* what);
+
+    std::FILE* file_  = nullptr;
+    uint64_t records_ = 0;
+    uint64_t dropped_ = 0;
+    std::atomic<bool> failed_{false};
+    std::string error_;
+};
+
+// Read-only memory map of a capture file; records are served in place without copying.
+class CaptureReader {
+public:
+    explicit CaptureReader(const std::string& path);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&)            = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    size_t size() const { return count_; }
+    const CaptureRecord& operator[](size_t index) const { return records_[index]; }
+
+private:
+    void* mapping_                = nullptr;
+    size_t mapping_size_          = 0;
+    const CaptureRecord* records_ = nullptr;
+    size_t count_                 = 0;
+};
+
+}  // namespace receiver
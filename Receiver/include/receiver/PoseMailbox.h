@@ -0,0 +1,41 @@
+#pragma once
+
+#include "receiver/TrackerClient.h"
+
+#include <chrono>
+#include <mutex>
+
+namespace receiver {
+
+// Latest-value handoff from the VRPN thread to the send loop. Writers overwrite, readers copy;
+// nothing queues, so a slow reader always sees the newest pose.
+class PoseMailbox {
+public:
+    using clock = std::chrono::steady_clock;
+
+    void publish(const Pose& pose, clock::time_point received) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pose_     = pose;
+        received_ = received;
+        has_pose_ = true;
+    }
+
+    // Returns false while nothing has been published.
+    bool read(Pose& pose, clock::time_point& received) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!has_pose_) {
+            return false;
+        }
+        pose     = pose_;
+        received = received_;
+        return true;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    Pose pose_{};
+    clock::time_point received_{};
+    bool has_pose_ = false;
+};
+
+}  // namespace receiver
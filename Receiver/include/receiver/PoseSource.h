@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace receiver {
+
+struct Pose {
+    double timestamp_sec = 0.0;
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+    double qx = 0.0;
+    double qy = 0.0;
+    double qz = 0.0;
+    double qw = 1.0;
+    double roll = 0.0;
+    double pitch = 0.0;
+    double yaw = 0.0;
+};
+
+struct TrackerStats {
+    uint64_t poses              = 0;
+    uint64_t disconnects        = 0;
+    uint64_t reconnect_attempts = 0;
+    double last_disconnect_s    = 0.0;  // connection failure until the next pose arrived
+    double total_disconnect_s   = 0.0;
+    double last_first_pose_s    = 0.0;  // tracker (re)created until its first pose
+    double max_first_pose_s     = 0.0;
+};
+
+class CaptureWriter;
+
+// Where the bridge gets poses for one tracker: a VRPN connection (TrackerClient) or the same-host
+// shared-memory table (ShmPoseSource). Driven from a single thread.
+class PoseSource {
+public:
+    using clock = std::chrono::steady_clock;
+
+    virtual ~PoseSource() = default;
+
+    // Never blocks. Returns false while the source is not live (backing off or reconnecting).
+    virtual bool spin_once() = 0;
+    virtual std::optional<Pose> latest_pose() const = 0;
+    virtual clock::time_point last_pose_time() const = 0;
+    virtual const TrackerStats& stats() const = 0;
+
+    // Every raw report is appended to `writer` (not owned) before conversion; nullptr disables.
+    virtual void set_capture(CaptureWriter* writer) = 0;
+};
+
+}  // namespace receiver
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "receiver/PoseSource.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace receiver {
+
+struct SourceStats {
+    uint64_t received    = 0;  // new samples seen from this source
+    uint64_t selected    = 0;  // samples forwarded from this source
+    uint64_t late        = 0;  // not newer than what another source already forwarded
+    uint64_t missed      = 0;  // forwarded from another source while this one was live, never seen here
+    uint64_t lag_samples = 0;
+    double lag_sum_s     = 0.0;  // arrival behind the first source to deliver the same sample
+    double lag_max_s     = 0.0;
+    double latency_sum_s = 0.0;  // local wall clock at arrival minus the sample's VRPN timestamp
+    double latency_max_s = 0.0;
+
+    double loss() const { return received + missed ? double(missed) / double(received + missed) : 0.0; }
+};
+
+// One tracker served by several redundant mocap servers, all spun from the same thread. Only a
+// sample newer than the last forwarded one can be forwarded. Samples from the active source (and
+// from the primary, i.e. the first source, which takes over again whenever it delivers one) go out
+// at once. A newer sample from any other source is held: the active source gets
+// `primary_tolerance_s` of arrival time to deliver a sample at least as new before the output
+// switches, or none if it is not live. Servers delivering the same frames with their arrival order
+// shuffled therefore never cause a switch. Forwarded timestamps never go backwards, which assumes
+// the servers stamp samples from a common clock (same mocap system, or hosts synchronised over
+// PTP/NTP).
+class RedundantPoseSource : public PoseSource {
+public:
+    RedundantPoseSource(std::vector<std::unique_ptr<PoseSource>> sources, double primary_tolerance_s);
+
+    bool spin_once() override;
+    // spin_once() with the hold tolerance measured up to `now`, so switching can be tested exactly.
+    bool spin_once(clock::time_point now);
+    std::optional<Pose> latest_pose() const override;
+    clock::time_point last_pose_time() const override { return last_pose_time_; }
+    // poses counts forwarded samples; the connection fields add up every source.
+    const TrackerStats& stats() const override { return stats_; }
+    // Only the primary records, so a capture holds one copy of each sample.
+    void set_capture(CaptureWriter* writer) override;
+
+    size_t size() const { return sources_.size(); }
+    const PoseSource& source(size_t index) const { return *sources_[index].source; }
+    const SourceStats& source_stats(size_t index) const { return sources_[index].stats; }
+    bool source_live(size_t index) const { return sources_[index].live; }
+    size_t active() const { return active_; }
+    uint64_t switches() const { return switches_; }
+
+private:
+    struct Pending {
+        double timestamp_sec;
+        clock::time_point arrival;
+    };
+
+    struct Entry {
+        std::unique_ptr<PoseSource> source;
+        SourceStats stats;
+        bool live = false;
+        clock::time_point seen{};  // last_pose_time() already accounted for
+        std::optional<Pose> fresh;  // new sample from this spin
+        std::deque<Pending> pending;  // samples forwarded from elsewhere this source has yet to match
+    };
+
+    void account(Entry& entry, const Pose& pose, clock::time_point arrival);
+    void forward(size_t index, const Pose& pose, clock::time_point arrival);
+
+    std::vector<Entry> sources_;
+    double tolerance_s_ = 0.0;
+    size_t active_      = 0;
+    uint64_t switches_  = 0;
+    // Newest sample from a source other than the active one, waiting for the active one to match it.
+    size_t held_ = 0;
+    bool holding_ = false;
+    Pose held_pose_{};
+    clock::time_point held_arrival_{};
+    clock::time_point held_since_{};  // arrival of the first sample held since the last forward
+    Pose last_pose_{};
+    bool have_pose_ = false;
+    clock::time_point last_pose_time_{};
+    TrackerStats stats_{};
+};
+
+}  // namespace receiver
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "receiver/PoseSource.h"
+
+#include "vrpn_common/SharedPoseTable.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace receiver {
+
+// Reads one tracker's slot from the shared-memory table the sender publishes with --shm. A poll is
+// a seqlock read straight out of the mapping: no syscall, no copy beyond the pose itself. A missing
+// segment is retried, and a writer restart (new segment under the same name) is detected once the
+// slot has been quiet for a while and counted as a disconnect; a re-created segment that no longer
+// lists the tracker is retried the same way until it does.
+class ShmPoseSource : public PoseSource {
+public:
+    // Throws std::runtime_error if the segment exists but does not publish `tracker`.
+    ShmPoseSource(const std::string& segment, const std::string& tracker);
+
+    bool spin_once() override;
+    // spin_once() at an explicit time, so retry and restart handling can be tested without sleeping.
+    bool spin_once(clock::time_point now);
+    std::optional<Pose> latest_pose() const override;
+    clock::time_point last_pose_time() const override { return last_pose_time_; }
+    const TrackerStats& stats() const override { return stats_; }
+    void set_capture(CaptureWriter* writer) override { capture_ = writer; }
+
+private:
+    bool attach(clock::time_point now);
+    void detach(clock::time_point now);
+
+    std::string segment_;
+    std::string tracker_;
+    std::unique_ptr<vrpn_common::SharedPoseReader> reader_;
+    size_t slot_            = 0;
+    uint32_t last_sequence_ = 0;
+    CaptureWriter* capture_ = nullptr;
+    Pose last_pose_{};
+    bool have_pose_       = false;
+    bool tracker_missing_ = false;  // the last attach found the segment but not the tracker
+
+    clock::time_point attached_at_{};
+    clock::time_point last_change_{};
+    clock::time_point next_check_{};
+    clock::time_point last_pose_time_{};
+    std::optional<clock::time_point> disconnected_at_;
+    TrackerStats stats_{};
+};
+
+}  // namespace receiver
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "receiver/PoseSource.h"
+
+#include <chrono>
 #include <optional>
+#include <random>
 #include <string>
 
 #include <vrpn_Connection.h>
@@ -8,35 +12,52 @@
 
 namespace receiver {
 
-struct Pose {
-    double timestamp_sec = 0.0;
-    double x = 0.0;
-    double y = 0.0;
-    double z = 0.0;
-    double roll = 0.0;
-    double pitch = 0.0;
-    double yaw = 0.0;
+void quaternion_to_euler(double qx, double qy, double qz, double qw, double& roll, double& pitch, double& yaw);
+Pose from_tracker_cb(const vrpn_TRACKERCB& info);
+
+struct ReconnectOptions {
+    double initial_backoff_s = 0.05;
+    double max_backoff_s     = 2.0;   // upper bound on the wait between attempts
+    double jitter_fraction   = 0.25;  // +/- share of each delay, de-synchronises a fleet of receivers
 };
 
-class TrackerClient {
+class TrackerClient : public PoseSource {
 public:
-    explicit TrackerClient(const std::string& address);
-    ~TrackerClient();
+    explicit TrackerClient(const std::string& address, const ReconnectOptions& reconnect = {});
+    ~TrackerClient() override;
 
-    bool spin_once();
-    std::optional<Pose> latest_pose() const;
+    // Never blocks: while backing off it only checks the retry deadline. Returns false when no
+    // tracker is live (backing off, or the connection just failed).
+    bool spin_once() override;
+    std::optional<Pose> latest_pose() const override;
+    clock::time_point last_pose_time() const override { return last_pose_time_; }
+    const TrackerStats& stats() const override { return stats_; }
+    void set_capture(CaptureWriter* writer) override { capture_ = writer; }
 
 private:
+    enum class State { kConnecting, kStreaming, kBackoff };
+
     void create_tracker();
     void destroy_tracker();
+    void enter_backoff(clock::time_point now);
 
     static void VRPN_CALLBACK handle_tracker(void* userdata, const vrpn_TRACKERCB info);
 
     std::string address_;
+    ReconnectOptions reconnect_;
     vrpn_Tracker_Remote* tracker_ = nullptr;
+    CaptureWriter* capture_       = nullptr;
     Pose last_pose_{};
     bool have_pose_ = false;
-    bool active_ = false;
+
+    State state_ = State::kConnecting;
+    int backoff_step_ = 0;
+    clock::time_point next_attempt_{};
+    clock::time_point attempt_started_{};
+    clock::time_point last_pose_time_{};
+    std::optional<clock::time_point> disconnected_at_;
+    std::mt19937 rng_{std::random_device{}()};
+    TrackerStats stats_{};
 };
 
 }  // namespace receiver
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "receiver/LinkScheduler.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace receiver {
+
+struct VehicleSpec {
+    std::string tracker;
+    uint8_t system_id = 1;
+    double weight     = 1.0;
+};
+
+// "<tracker>:<sysid>[:<weight>]", as given to --vehicle. Throws std::invalid_argument.
+VehicleSpec parse_vehicle_spec(const std::string& text);
+// All of `text` as a number; std::stod alone accepts "50abc" and reports errors as "stod".
+// Throws std::invalid_argument naming `what`.
+double parse_number(const std::string& text, const char* what);
+// A MAVLink system ID, 1-255. Throws std::invalid_argument.
+uint8_t parse_system_id(const std::string& text);
+
+// The vehicles sharing one link, each in a LinkScheduler slot, and the control socket commands that
+// change them while the bridge runs. The roster keeps the tracker name and system ID per slot and
+// refuses a second live vehicle with either; the bridge attaches sources, mailboxes and transform
+// slots through the hooks. Used from the send thread only, like the scheduler it drives.
+class VehicleRoster {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Hooks {
+        // `slot` was claimed for `spec`. Throwing refuses the vehicle and the slot is given back.
+        std::function<void(size_t slot, const VehicleSpec& spec)> added;
+        // `slot` is about to be freed.
+        std::function<void(size_t slot)> removed;
+        // Extra " key=value" fields for the `stats` line of `slot`.
+        std::function<std::string(size_t slot)> describe;
+        // Lines `stats` prints after the vehicles, each newline-terminated.
+        std::function<std::string()> link_summary;
+    };
+
+    VehicleRoster(LinkScheduler& scheduler, double default_rate_hz, Hooks hooks);
+
+    // Returns the slot, a free one if there is any. Throws std::invalid_argument if the tracker or
+    // system ID is already live, or whatever the `added` hook throws.
+    size_t add(const VehicleSpec& spec, double requested_hz);
+    void remove(size_t slot);
+    // Throws std::invalid_argument if another live vehicle has `system_id`.
+    void set_system_id(size_t slot, uint8_t system_id);
+    // Throws std::invalid_argument if `tracker` is not forwarded.
+    size_t find(const std::string& tracker) const;
+
+    // Slots, including free ones; the same count as the scheduler's.
+    size_t size() const { return slots_.size(); }
+    bool active(size_t slot) const { return slot < slots_.size() && slots_[slot].active; }
+    const VehicleSpec& spec(size_t slot) const { return slots_[slot].spec; }
+    // Rate of vehicles added without one; `rate all` changes it.
+    double default_rate_hz() const { return default_rate_hz_; }
+
+    // "uav0 50.0 Hz, uav1 25.0 Hz" over the live vehicles.
+    std::string allocation_summary() const;
+
+    // Runs one command line (without its newline), for ControlSocket. The reply ends in a line
+    // starting "ok" or "error:"; a change that moves the link split answers with the new allocation.
+    std::string handle(const std::string& line);
+
+private:
+    struct Slot {
+        VehicleSpec spec;
+        bool active = false;
+        clock::time_point added{};
+    };
+
+    void check_unique(const VehicleSpec& spec, size_t except) const;
+    std::string stats() const;
+
+    LinkScheduler& scheduler_;
+    double default_rate_hz_ = 0.0;
+    Hooks hooks_;
+    std::vector<Slot> slots_;
+};
+
+}  // namespace receiver
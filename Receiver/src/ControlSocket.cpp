@@ -0,0 +1,158 @@
+#include "receiver/ControlSocket.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace receiver {
+namespace {
+
+// A handful of operators at most; anything beyond is refused rather than queued.
+constexpr size_t kMaxClients = 8;
+// Longer than any command; a client sending more without a newline is not speaking the protocol.
+constexpr size_t kMaxLineLength = 1024;
+// A client that stops reading is dropped before its replies pile up.
+constexpr size_t kMaxPendingOutput = 64 * 1024;
+// Commands run on the send thread between ticks; a client pasting a long script gets through it a
+// few lines per tick instead of stalling the loop.
+constexpr size_t kMaxCommandsPerPoll = 8;
+// Lines waiting for a later poll, so a client that keeps sending faster than that is dropped.
+constexpr size_t kMaxPendingInput = 64 * 1024;
+
+}  // namespace
+
+ControlSocket::ControlSocket(const std::string& path) : path_(path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Control socket path must be 1-" + std::to_string(sizeof(address.sun_path) - 1) +
+                                 " characters: '" + path + "'");
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    struct stat existing {};
+    if (::lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw std::runtime_error("Control socket path " + path + " exists and is not a socket");
+        }
+        ::unlink(path.c_str());
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("Failed to create control socket: ") + std::strerror(errno));
+    }
+    // Owner only: the commands change what the FC is sent. Nobody can connect before listen().
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(listen_fd_, static_cast<int>(kMaxClients)) != 0 ||
+        ::fcntl(listen_fd_, F_SETFL, ::fcntl(listen_fd_, F_GETFL) | O_NONBLOCK) != 0) {
+        const std::string reason = std::strerror(errno);
+        ::close(listen_fd_);
+        throw std::runtime_error("Failed to listen on control socket " + path + ": " + reason);
+    }
+}
+
+ControlSocket::~ControlSocket() {
+    for (auto& client : clients_) {
+        ::close(client.fd);
+    }
+    ::close(listen_fd_);
+    ::unlink(path_.c_str());
+}
+
+void ControlSocket::poll(const Handler& handler) {
+    for (;;) {
+        const int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            break;  // EAGAIN: nobody waiting
+        }
+        if (clients_.size() >= kMaxClients ||
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+            ::close(fd);
+            continue;
+        }
+        Client client;
+        client.fd = fd;
+        clients_.push_back(std::move(client));
+    }
+
+    for (size_t i = 0; i < clients_.size();) {
+        if (service(clients_[i], handler)) {
+            ++i;
+            continue;
+        }
+        ::close(clients_[i].fd);
+        clients_.erase(clients_.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+}
+
+bool ControlSocket::service(Client& client, const Handler& handler) {
+    char buffer[512];
+    bool peer_closed = false;
+    while (client.input.size() <= kMaxPendingInput) {
+        const ssize_t length = ::recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (length == 0) {
+            peer_closed = true;  // `echo stats | socat ...` half-closes, then waits for the reply
+            break;
+        }
+        if (length < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        client.input.append(buffer, static_cast<size_t>(length));
+    }
+
+    if (peer_closed && !client.input.empty() && client.input.back() != '\n') {
+        client.input += '\n';  // last command sent without a newline
+    }
+    size_t start    = 0;
+    size_t commands = 0;
+    for (size_t end = client.input.find('\n'); end != std::string::npos && commands < kMaxCommandsPerPoll;
+         end = client.input.find('\n', start)) {
+        std::string line = client.input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        start = end + 1;
+        if (!line.empty()) {
+            client.output += handler(line);
+            ++commands;
+        }
+    }
+    client.input.erase(0, start);
+    const size_t last_newline = client.input.rfind('\n');
+    const size_t partial      = last_newline == std::string::npos ? client.input.size()
+                                                                  : client.input.size() - last_newline - 1;
+    if (partial > kMaxLineLength || client.input.size() > kMaxPendingInput) {
+        return false;
+    }
+    // Lines left for the next poll keep a closed peer around until they are answered.
+    const bool done = peer_closed && last_newline == std::string::npos;
+    // A closed peer gets one attempt at its replies; small ones always fit the socket buffer.
+    return flush(client) && !done && client.output.size() <= kMaxPendingOutput;
+}
+
+bool ControlSocket::flush(Client& client) {
+    while (!client.output.empty()) {
+        const ssize_t written =
+            ::send(client.fd, client.output.data(), client.output.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (written < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client.output.erase(0, static_cast<size_t>(written));
+    }
+    return true;
+}
+
+}  // namespace receiver
@@ -0,0 +1,280 @@
+#include "receiver/FrameTransform.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace receiver {
+namespace {
+
+using Mat3 = std::array<double, 9>;  // row-major
+
+struct Quat {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+    double w = 1.0;
+};
+
+constexpr Mat3 kIdentity = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+// ENU → NED swaps east/north and flips up; FLU → FRD is a half turn about the forward axis.
+constexpr Mat3 kEnuToNed = {0, 1, 0, 1, 0, 0, 0, 0, -1};
+constexpr Mat3 kFluToFrd = {1, 0, 0, 0, -1, 0, 0, 0, -1};
+
+// Y-up (X right, Y up, Z back): north = -Z, east = X, down = -Y.
+constexpr Mat3 kYUpToNed = {0, 0, -1, 1, 0, 0, 0, -1, 0};
+constexpr Mat3 kNedToYUp = {0, 1, 0, 0, 0, -1, -1, 0, 0};
+
+Mat3 multiply(const Mat3& a, const Mat3& b) {
+    Mat3 out{};
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            out[r * 3 + c] = a[r * 3] * b[c] + a[r * 3 + 1] * b[3 + c] + a[r * 3 + 2] * b[6 + c];
+        }
+    }
+    return out;
+}
+
+Mat3 yaw_rotation(double yaw) {
+    const double c = std::cos(yaw);
+    const double s = std::sin(yaw);
+    return {c, -s, 0, s, c, 0, 0, 0, 1};
+}
+
+Quat quat_from_matrix(const Mat3& m) {
+    Quat q;
+    const double trace = m[0] + m[4] + m[8];
+    if (trace > 0.0) {
+        const double s = 2.0 * std::sqrt(trace + 1.0);
+        q.w            = 0.25 * s;
+        q.x            = (m[7] - m[5]) / s;
+        q.y            = (m[2] - m[6]) / s;
+        q.z            = (m[3] - m[1]) / s;
+    } else if (m[0] > m[4] && m[0] > m[8]) {
+        const double s = 2.0 * std::sqrt(1.0 + m[0] - m[4] - m[8]);
+        q.w            = (m[7] - m[5]) / s;
+        q.x            = 0.25 * s;
+        q.y            = (m[1] + m[3]) / s;
+        q.z            = (m[2] + m[6]) / s;
+    } else if (m[4] > m[8]) {
+        const double s = 2.0 * std::sqrt(1.0 + m[4] - m[0] - m[8]);
+        q.w            = (m[2] - m[6]) / s;
+        q.x            = (m[1] + m[3]) / s;
+        q.y            = 0.25 * s;
+        q.z            = (m[5] + m[7]) / s;
+    } else {
+        const double s = 2.0 * std::sqrt(1.0 + m[8] - m[0] - m[4]);
+        q.w            = (m[3] - m[1]) / s;
+        q.x            = (m[2] + m[6]) / s;
+        q.y            = (m[5] + m[7]) / s;
+        q.z            = 0.25 * s;
+    }
+    return q;
+}
+
+}  // namespace
+
+MocapFrame parse_mocap_frame(const std::string& name) {
+    if (name == "none") {
+        return MocapFrame::kNone;
+    }
+    if (name == "enu") {
+        return MocapFrame::kEnu;
+    }
+    if (name == "yup") {
+        return MocapFrame::kYUp;
+    }
+    throw std::invalid_argument("Unknown frame: " + name + " (expected none, enu or yup)");
+}
+
+std::array<double, 3> parse_vector3(const std::string& value) {
+    // Exactly three comma-separated numbers: "1,2,3,4", "1,2," and "1,2,3m" are all rejected.
+    std::array<double, 3> out{};
+    size_t begin = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        const size_t end = i + 1 < out.size() ? value.find(',', begin) : value.size();
+        if (end == std::string::npos) {
+            throw std::invalid_argument("Expected x,y,z but got: " + value);
+        }
+        const std::string item = value.substr(begin, end - begin);
+        size_t used            = 0;
+        try {
+            out[i] = std::stod(item, &used);
+        } catch (const std::exception&) {
+            used = 0;
+        }
+        if (used == 0 || used != item.size()) {
+            throw std::invalid_argument("Expected x,y,z but got: " + value);
+        }
+        begin = end + 1;
+    }
+    return out;
+}
+
+void PoseBatch::resize(size_t count) {
+    for (auto* column : {&timestamp_sec, &x, &y, &z, &qx, &qy, &qz, &roll, &pitch, &yaw}) {
+        column->resize(count, 0.0);
+    }
+    qw.resize(count, 1.0);
+}
+
+void PoseBatch::set(size_t index, const Pose& pose) {
+    timestamp_sec[index] = pose.timestamp_sec;
+    x[index]             = pose.x;
+    y[index]             = pose.y;
+    z[index]             = pose.z;
+    qx[index]            = pose.qx;
+    qy[index]            = pose.qy;
+    qz[index]            = pose.qz;
+    qw[index]            = pose.qw;
+    roll[index]          = pose.roll;
+    pitch[index]         = pose.pitch;
+    yaw[index]           = pose.yaw;
+}
+
+Pose PoseBatch::get(size_t index) const {
+    Pose pose;
+    pose.timestamp_sec = timestamp_sec[index];
+    pose.x             = x[index];
+    pose.y             = y[index];
+    pose.z             = z[index];
+    pose.qx            = qx[index];
+    pose.qy            = qy[index];
+    pose.qz            = qz[index];
+    pose.qw            = qw[index];
+    pose.roll          = roll[index];
+    pose.pitch         = pitch[index];
+    pose.yaw           = yaw[index];
+    return pose;
+}
+
+size_t FrameTransformStage::add_tracker(const FrameTransformOptions& options) {
+    Mat3 world = kIdentity;
+    Mat3 body  = kIdentity;
+    switch (options.frame) {
+        case MocapFrame::kNone:
+            break;
+        case MocapFrame::kEnu:
+            world = kEnuToNed;
+            body  = kFluToFrd;
+            break;
+        case MocapFrame::kYUp:
+            world = kYUpToNed;
+            body  = kNedToYUp;
+            break;
+    }
+    // The yaw offset turns the converted world about the down axis, so it composes on the left.
+    world = multiply(yaw_rotation(options.yaw_offset_rad), world);
+
+    const Quat pre  = quat_from_matrix(world);
+    const Quat post = quat_from_matrix(body);
+
+    for (size_t i = 0; i < rot_.size(); ++i) {
+        rot_[i].push_back(world[i]);
+    }
+    tx_.push_back(options.origin_offset[0]);
+    ty_.push_back(options.origin_offset[1]);
+    tz_.push_back(options.origin_offset[2]);
+    pre_x_.push_back(pre.x);
+    pre_y_.push_back(pre.y);
+    pre_z_.push_back(pre.z);
+    pre_w_.push_back(pre.w);
+    post_x_.push_back(post.x);
+    post_y_.push_back(post.y);
+    post_z_.push_back(post.z);
+    post_w_.push_back(post.w);
+    body_x_.push_back(options.body_offset[0]);
+    body_y_.push_back(options.body_offset[1]);
+    body_z_.push_back(options.body_offset[2]);
+    return tx_.size() - 1;
+}
+
+void FrameTransformStage::apply(PoseBatch& batch) const {
+    if (batch.size() != size()) {
+        throw std::invalid_argument("PoseBatch size does not match the number of transformed trackers");
+    }
+    transform(batch, size(), [](size_t k) { return k; });
+}
+
+void FrameTransformStage::apply(PoseBatch& batch, const std::vector<size_t>& slots) const {
+    if (batch.size() != size()) {
+        throw std::invalid_argument("PoseBatch size does not match the number of transformed trackers");
+    }
+    for (size_t slot : slots) {
+        if (slot >= size()) {
+            throw std::out_of_range("PoseBatch slot " + std::to_string(slot) + " has no transform");
+        }
+    }
+    const size_t* indices = slots.data();
+    transform(batch, slots.size(), [indices](size_t k) { return indices[k]; });
+}
+
+// Shared by both apply() overloads. With the identity mapping the slots are contiguous and the
+// loop vectorises; an index list gathers instead, which is still cheaper than transforming every
+// slot when only a few of them are due.
+template <typename SlotOf>
+void FrameTransformStage::transform(PoseBatch& batch, size_t count, SlotOf slot_of) const {
+    double* __restrict px = batch.x.data();
+    double* __restrict py = batch.y.data();
+    double* __restrict pz = batch.z.data();
+    double* __restrict qx = batch.qx.data();
+    double* __restrict qy = batch.qy.data();
+    double* __restrict qz = batch.qz.data();
+    double* __restrict qw = batch.qw.data();
+
+    const double* __restrict r0 = rot_[0].data();
+    const double* __restrict r1 = rot_[1].data();
+    const double* __restrict r2 = rot_[2].data();
+    const double* __restrict r3 = rot_[3].data();
+    const double* __restrict r4 = rot_[4].data();
+    const double* __restrict r5 = rot_[5].data();
+    const double* __restrict r6 = rot_[6].data();
+    const double* __restrict r7 = rot_[7].data();
+    const double* __restrict r8 = rot_[8].data();
+
+    // Branch-free body: every line maps to packed SIMD arithmetic once vectorised.
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i  = slot_of(k);
+        const double ix = px[i];
+        const double iy = py[i];
+        const double iz = pz[i];
+
+        // q_out = pre ⊗ q_in ⊗ post
+        const double aw = pre_w_[i] * qw[i] - pre_x_[i] * qx[i] - pre_y_[i] * qy[i] - pre_z_[i] * qz[i];
+        const double ax = pre_w_[i] * qx[i] + pre_x_[i] * qw[i] + pre_y_[i] * qz[i] - pre_z_[i] * qy[i];
+        const double ay = pre_w_[i] * qy[i] - pre_x_[i] * qz[i] + pre_y_[i] * qw[i] + pre_z_[i] * qx[i];
+        const double az = pre_w_[i] * qz[i] + pre_x_[i] * qy[i] - pre_y_[i] * qx[i] + pre_z_[i] * qw[i];
+
+        const double ow = aw * post_w_[i] - ax * post_x_[i] - ay * post_y_[i] - az * post_z_[i];
+        const double ox = aw * post_x_[i] + ax * post_w_[i] + ay * post_z_[i] - az * post_y_[i];
+        const double oy = aw * post_y_[i] - ax * post_z_[i] + ay * post_w_[i] + az * post_x_[i];
+        const double oz = aw * post_z_[i] + ax * post_y_[i] - ay * post_x_[i] + az * post_w_[i];
+
+        // Lever arm rotated into the world: v + w * t + q × t with t = 2 * (q × v).
+        const double bx = body_x_[i];
+        const double by = body_y_[i];
+        const double bz = body_z_[i];
+        const double cx = 2.0 * (oy * bz - oz * by);
+        const double cy = 2.0 * (oz * bx - ox * bz);
+        const double cz = 2.0 * (ox * by - oy * bx);
+        const double lx = bx + ow * cx + (oy * cz - oz * cy);
+        const double ly = by + ow * cy + (oz * cx - ox * cz);
+        const double lz = bz + ow * cz + (ox * cy - oy * cx);
+
+        px[i] = r0[i] * ix + r1[i] * iy + r2[i] * iz + tx_[i] + lx;
+        py[i] = r3[i] * ix + r4[i] * iy + r5[i] * iz + ty_[i] + ly;
+        pz[i] = r6[i] * ix + r7[i] * iy + r8[i] * iz + tz_[i] + lz;
+        qx[i] = ox;
+        qy[i] = oy;
+        qz[i] = oz;
+        qw[i] = ow;
+    }
+
+    // The trig calls stay in their own pass so they do not block vectorising the loop above.
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = slot_of(k);
+        quaternion_to_euler(qx[i], qy[i], qz[i], qw[i], batch.roll[i], batch.pitch[i], batch.yaw[i]);
+    }
+}
+
+}  // namespace receiver
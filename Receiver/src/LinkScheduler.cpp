@@ -0,0 +1,161 @@
+#include "receiver/LinkScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace receiver {
+
+namespace {
+
+// Token caps. A vehicle may bank half a slot to absorb tick granularity; the link bucket holds
+// about 10 ms of line time so nothing larger than that ever waits in the UART buffer.
+constexpr double kVehicleBurst = 1.5;
+constexpr double kLinkWindowS  = 0.010;
+
+}  // namespace
+
+LinkScheduler::LinkScheduler(double link_bytes_per_s, double frame_bytes)
+    : link_bytes_per_s_(std::max(link_bytes_per_s, 0.0)),
+      frame_bytes_(std::max(frame_bytes, 1.0)),
+      allocated_bytes_(frame_bytes_) {}
+
+size_t LinkScheduler::add_vehicle(double requested_hz, double weight) {
+    Vehicle vehicle;
+    vehicle.share.requested_hz = std::max(requested_hz, 0.0);
+    vehicle.share.weight       = weight > 0.0 ? weight : 1.0;
+    const auto free_slot = std::find_if(vehicles_.begin(), vehicles_.end(),
+                                        [](const Vehicle& existing) { return !existing.active; });
+    size_t index = vehicles_.size();
+    if (free_slot != vehicles_.end()) {
+        index      = static_cast<size_t>(free_slot - vehicles_.begin());
+        *free_slot = vehicle;
+    } else {
+        vehicles_.push_back(vehicle);
+    }
+    allocate();
+    return index;
+}
+
+void LinkScheduler::remove_vehicle(size_t index) {
+    Vehicle& vehicle = vehicles_[index];
+    vehicle.active   = false;
+    vehicle.tokens   = 0.0;
+    vehicle.share    = VehicleShare{};
+    allocate();
+}
+
+void LinkScheduler::set_rate(size_t index, double requested_hz) {
+    vehicles_[index].share.requested_hz = std::max(requested_hz, 0.0);
+    allocate();
+}
+
+void LinkScheduler::set_paused(size_t index, bool paused) {
+    if (vehicles_[index].paused != paused) {
+        vehicles_[index].paused = paused;
+        allocate();
+    }
+}
+
+double LinkScheduler::capacity_hz() const {
+    return limited() ? link_bytes_per_s_ / frame_bytes_ : INFINITY;
+}
+
+void LinkScheduler::allocate() {
+    if (!limited()) {
+        for (auto& vehicle : vehicles_) {
+            vehicle.share.allocated_hz = vehicle.active && !vehicle.paused ? vehicle.share.requested_hz : 0.0;
+        }
+        return;
+    }
+
+    // Water-filling: repeatedly split what is left by weight, fixing every vehicle whose demand
+    // fits inside its share, until the remaining ones are all capped by the share itself.
+    double remaining = capacity_hz();
+    std::vector<Vehicle*> open;
+    for (auto& vehicle : vehicles_) {
+        if (vehicle.active && !vehicle.paused) {
+            open.push_back(&vehicle);
+        } else {
+            vehicle.share.allocated_hz = 0.0;
+        }
+    }
+    while (!open.empty()) {
+        double weight_sum = 0.0;
+        for (const Vehicle* vehicle : open) {
+            weight_sum += vehicle->share.weight;
+        }
+        const double per_weight = remaining / weight_sum;
+        const auto satisfied    = std::partition(open.begin(), open.end(), [per_weight](const Vehicle* vehicle) {
+            return vehicle->share.requested_hz > per_weight * vehicle->share.weight;
+        });
+        if (satisfied == open.end()) {
+            for (Vehicle* vehicle : open) {
+                vehicle->share.allocated_hz = per_weight * vehicle->share.weight;
+            }
+            break;
+        }
+        for (auto it = satisfied; it != open.end(); ++it) {
+            (*it)->share.allocated_hz = (*it)->share.requested_hz;
+            remaining -= (*it)->share.requested_hz;
+        }
+        open.erase(satisfied, open.end());
+    }
+    allocated_bytes_ = frame_bytes_;
+}
+
+void LinkScheduler::advance(clock::time_point now) {
+    if (!started_) {
+        started_      = true;
+        last_advance_ = now;
+        link_tokens_  = limited() ? link_bytes_per_s_ * kLinkWindowS : 0.0;
+        return;
+    }
+    const double dt = std::chrono::duration<double>(now - last_advance_).count();
+    last_advance_   = now;
+    if (dt <= 0.0) {
+        return;
+    }
+    for (auto& vehicle : vehicles_) {
+        vehicle.tokens = std::min(vehicle.tokens + vehicle.share.allocated_hz * dt, kVehicleBurst);
+    }
+    if (limited()) {
+        const double window = std::max(link_bytes_per_s_ * kLinkWindowS, frame_bytes_);
+        link_tokens_        = std::min(link_tokens_ + link_bytes_per_s_ * dt, window);
+    }
+}
+
+bool LinkScheduler::acquire(size_t index) {
+    Vehicle& vehicle = vehicles_[index];
+    if (vehicle.tokens < 1.0) {
+        return false;
+    }
+    if (limited()) {
+        if (link_tokens_ < frame_bytes_) {
+            ++vehicle.share.deferred;
+            return false;
+        }
+        link_tokens_ -= frame_bytes_;
+    }
+    vehicle.tokens -= 1.0;
+    return true;
+}
+
+void LinkScheduler::commit(size_t index, size_t bytes) {
+    if (bytes == 0) {
+        ++vehicles_[index].share.dropped;
+        return;
+    }
+    ++vehicles_[index].share.sent;
+    if (!limited()) {
+        return;
+    }
+    link_tokens_ += frame_bytes_ - static_cast<double>(bytes);
+    // MAVLink 2 trims trailing zero bytes, so frame size drifts with the data. Re-split the budget
+    // when the running average moves by more than 10 %.
+    frame_bytes_ += (static_cast<double>(bytes) - frame_bytes_) * 0.05;
+    if (std::abs(frame_bytes_ - allocated_bytes_) > 0.1 * allocated_bytes_) {
+        allocate();
+    }
+}
+
+}  // namespace receiver
@@ -0,0 +1,206 @@
+#include "receiver/MavlinkRelay.h"
+
+#include "vrpn_common/Trace.h"
+
+// Every dialect the vendored headers know, so ArduPilot, PX4 and companion-specific messages pass
+// the CRC check (it needs each message's CRC_EXTRA) instead of being dropped as corrupt.
+#include <all/mavlink.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace receiver {
+namespace {
+
+// One read's worth; a UDP datagram from a GCS carries at most a few frames.
+constexpr size_t kReadChunk = 2048;
+
+size_t wire_length(const mavlink_message_t& message) {
+    if (message.magic == MAVLINK_STX_MAVLINK1) {
+        return MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 + MAVLINK_NUM_CHECKSUM_BYTES + message.len;
+    }
+    const size_t signature = (message.incompat_flags & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_BLOCK_LEN : 0;
+    return MAVLINK_NUM_HEADER_BYTES + MAVLINK_NUM_CHECKSUM_BYTES + message.len + signature;
+}
+
+// A socket's pending error (an ICMP port unreachable from a peer that is not up yet) is cleared by
+// reading SO_ERROR. A hang-up, an invalid fd or an error on anything else (a serial adapter that
+// was unplugged) stays, and poll() would report it again at once on every pass.
+bool error_cleared(int fd, short revents) {
+    if (revents & (POLLHUP | POLLNVAL)) {
+        return false;
+    }
+    int error      = 0;
+    socklen_t size = sizeof(error);
+    return ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == 0;
+}
+
+}  // namespace
+
+// Incremental parser for one direction. A frame that lies entirely inside the chunk being fed is
+// handed on in place; only one that straddles two reads is assembled from the saved tail.
+struct MavlinkRelay::FrameParser {
+    mavlink_message_t rx_message{};
+    mavlink_status_t rx_status{};
+    std::vector<uint8_t> tail;  // end of the previous chunk while a frame is in progress
+    std::vector<uint8_t> assembled;
+
+    // Counts frames with a bad CRC or signature in `crc_errors`, and those forwarded unchecked
+    // because no vendored dialect has their CRC_EXTRA in `unknown`.
+    template <typename OnFrame>
+    void feed(const uint8_t* data, size_t length, uint64_t& crc_errors, uint64_t& unknown, OnFrame&& on_frame) {
+        for (size_t i = 0; i < length; ++i) {
+            mavlink_message_t message{};
+            mavlink_status_t status{};
+            const uint8_t result = mavlink_frame_char_buffer(&rx_message, &rx_status, data[i], &message, &status);
+            // The framing (magic, length, signature block) is intact; only the CRC could not be checked.
+            const bool unchecked = result == MAVLINK_FRAMING_BAD_CRC && !mavlink_get_msg_entry(message.msgid);
+            if (unchecked) {
+                ++unknown;
+            } else if (result == MAVLINK_FRAMING_BAD_CRC || result == MAVLINK_FRAMING_BAD_SIGNATURE) {
+                ++crc_errors;
+                continue;
+            } else if (result != MAVLINK_FRAMING_OK) {
+                continue;
+            }
+            const size_t frame_length = wire_length(message);
+            const size_t end          = i + 1;
+            if (end >= frame_length) {
+                on_frame(data + end - frame_length, frame_length);
+            } else {
+                const size_t from_tail = std::min(frame_length - end, tail.size());
+                assembled.assign(tail.end() - from_tail, tail.end());
+                assembled.insert(assembled.end(), data, data + end);
+                on_frame(assembled.data(), assembled.size());
+            }
+        }
+
+        if (rx_status.parse_state == MAVLINK_PARSE_STATE_IDLE || rx_status.parse_state == MAVLINK_PARSE_STATE_UNINIT) {
+            tail.clear();
+        } else {
+            tail.insert(tail.end(), data, data + length);
+            if (tail.size() > kMaxMavlinkFrameLength) {
+                tail.erase(tail.begin(), tail.end() - kMaxMavlinkFrameLength);
+            }
+        }
+    }
+};
+
+MavlinkRelay::MavlinkRelay(MavlinkSender& fc_link, const std::vector<std::string>& gcs_endpoints,
+                           uint16_t bind_port)
+    : fc_link_(fc_link), fc_parser_(std::make_unique<FrameParser>()), gcs_parser_(std::make_unique<FrameParser>()) {
+    for (const auto& endpoint : gcs_endpoints) {
+        gcs_endpoints_.push_back(resolve_udp_endpoint(endpoint));
+    }
+    gcs_socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (gcs_socket_ < 0) {
+        throw std::runtime_error(std::string("Failed to create GCS socket: ") + std::strerror(errno));
+    }
+    sockaddr_in local{};
+    local.sin_family      = AF_INET;
+    local.sin_port        = htons(bind_port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    socklen_t local_size  = sizeof(local);
+    if (::bind(gcs_socket_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+        ::getsockname(gcs_socket_, reinterpret_cast<sockaddr*>(&local), &local_size) != 0) {
+        const std::string reason = std::strerror(errno);
+        ::close(gcs_socket_);
+        throw std::runtime_error("Failed to bind GCS socket to port " + std::to_string(bind_port) + ": " + reason);
+    }
+    local_port_ = ntohs(local.sin_port);
+}
+
+MavlinkRelay::~MavlinkRelay() {
+    if (gcs_socket_ >= 0) {
+        ::close(gcs_socket_);
+    }
+}
+
+void MavlinkRelay::service_until(clock::time_point deadline) {
+    // poll() skips negative fds, so a lost side is simply left out.
+    pollfd fds[2] = {{fc_lost_ ? -1 : fc_link_.link_fd(), POLLIN, 0}, {gcs_lost_ ? -1 : gcs_socket_, POLLIN, 0}};
+    constexpr short kFailed = POLLERR | POLLHUP | POLLNVAL;
+    for (;;) {
+        const auto now = clock::now();
+        if (now >= deadline) {
+            return;
+        }
+        const int timeout_ms = static_cast<int>(std::ceil(std::chrono::duration<double, std::milli>(deadline - now).count()));
+        const int ready      = ::poll(fds, 2, timeout_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                return;  // let the loop see a pending shutdown
+            }
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+        if ((fds[0].revents & kFailed) && !error_cleared(fds[0].fd, fds[0].revents)) {
+            fc_lost_  = true;
+            fds[0].fd = -1;
+        } else if (fds[0].revents & POLLIN) {
+            read_fc();
+        }
+        if ((fds[1].revents & kFailed) && !error_cleared(fds[1].fd, fds[1].revents)) {
+            gcs_lost_ = true;
+            fds[1].fd = -1;
+        } else if (fds[1].revents & POLLIN) {
+            read_gcs();
+        }
+    }
+}
+
+void MavlinkRelay::read_fc() {
+    VRPN_TRACE_SCOPE("relay_fc");
+    const auto forward = [&](const uint8_t* frame, size_t frame_length) {
+        ++stats_.fc_frames;
+        stats_.fc_bytes += frame_length;
+        for (const auto& endpoint : gcs_endpoints_) {
+            if (::sendto(gcs_socket_, frame, frame_length, MSG_DONTWAIT,
+                         reinterpret_cast<const sockaddr*>(&endpoint), sizeof(endpoint)) < 0) {
+                ++stats_.send_errors;
+            }
+        }
+    };
+    uint8_t buffer[kReadChunk];
+    size_t length = 0;
+    while ((length = fc_link_.read_link(buffer, sizeof(buffer))) > 0) {
+        fc_parser_->feed(buffer, length, stats_.fc_crc_errors, stats_.fc_unknown, forward);
+    }
+}
+
+void MavlinkRelay::read_gcs() {
+    VRPN_TRACE_SCOPE("relay_gcs");
+    uint8_t buffer[kReadChunk];
+    for (;;) {
+        sockaddr_in source{};
+        socklen_t source_size = sizeof(source);
+        const ssize_t length  = ::recvfrom(gcs_socket_, buffer, sizeof(buffer), MSG_DONTWAIT,
+                                          reinterpret_cast<sockaddr*>(&source), &source_size);
+        if (length <= 0) {
+            return;  // drained (EAGAIN), or an ICMP error from an endpoint that is not listening yet
+        }
+        // The socket listens on every interface; only the configured GCS may command the FC.
+        const bool known = std::any_of(gcs_endpoints_.begin(), gcs_endpoints_.end(), [&](const sockaddr_in& endpoint) {
+            return endpoint.sin_addr.s_addr == source.sin_addr.s_addr && endpoint.sin_port == source.sin_port;
+        });
+        if (source.sin_family != AF_INET || !known) {
+            ++stats_.gcs_rejected;
+            continue;
+        }
+        gcs_parser_->feed(buffer,
+                          static_cast<size_t>(length),
+                          stats_.gcs_crc_errors,
+                          stats_.gcs_unknown,
+                          [&](const uint8_t* frame, size_t frame_length) {
+                              ++stats_.gcs_frames;
+                              fc_link_.send_frame(frame, frame_length);
+                          });
+    }
+}
+
+}  // namespace receiver
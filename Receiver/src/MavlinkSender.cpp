@@ -1,5 +1,7 @@
 #include "receiver/MavlinkSender.h"
 
+#include "vrpn_common/Trace.h"
+
 #include <common/mavlink.h>
 
 #include <arpa/inet.h>
@@ -12,6 +14,9 @@
 #include <unistd.h>
 
 namespace receiver {
+
+static_assert(kMaxMavlinkFrameLength == MAVLINK_MAX_PACKET_LEN, "keep kMaxMavlinkFrameLength in sync with MAVLink");
+
 namespace {
 
 speed_t to_speed_t(int baud_rate) {
@@ -29,48 +34,67 @@ speed_t to_speed_t(int baud_rate) {
     }
 }
 
-std::pair<std::string, uint16_t> parse_udp_target(const std::string& target) {
-    auto pos = target.find(':');
+}  // namespace
+
+sockaddr_in resolve_udp_endpoint(const std::string& host_port) {
+    auto pos = host_port.find(':');
     if (pos == std::string::npos) {
         throw std::invalid_argument("UDP target must be host:port");
     }
-    std::string host = target.substr(0, pos);
-    uint16_t port    = static_cast<uint16_t>(std::stoi(target.substr(pos + 1)));
-    return {host, port};
+    const std::string host = host_port.substr(0, pos);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(static_cast<uint16_t>(std::stoi(host_port.substr(pos + 1))));
+    if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw std::invalid_argument("Invalid UDP host: " + host);
+    }
+    return address;
 }
 
-}  // namespace
-
 MavlinkSender::MavlinkSender(const MavlinkOptions& options)
     : system_id_(options.system_id), component_id_(options.component_id) {
     if (options.link_type == "serial") {
-        use_udp_ = false;
-        open_serial(options.serial_device, options.baud_rate);
+        link_ = open_serial(options.serial_device, options.baud_rate);
     } else if (options.link_type == "udp") {
-        use_udp_ = true;
-        open_udp(options.udp_target);
+        link_ = open_udp(options.udp_target);
     } else {
         throw std::invalid_argument("Unknown link type: " + options.link_type);
     }
+    try {
+        for (const auto& spec : options.mirrors) {
+            mirrors_.push_back(open_mirror(spec));
+        }
+    } catch (...) {
+        for (const auto& sink : mirrors_) {
+            ::close(sink.fd);
+        }
+        ::close(link_.fd);
+        throw;
+    }
 }
 
 MavlinkSender::~MavlinkSender() {
-    if (use_udp_) {
-        if (udp_socket_ >= 0) {
-            ::close(udp_socket_);
-        }
-    } else if (fd_ >= 0) {
-        ::close(fd_);
+    for (const auto& sink : mirrors_) {
+        ::close(sink.fd);
+    }
+    if (link_.fd >= 0) {
+        ::close(link_.fd);
     }
 }
 
-void MavlinkSender::send_pose(const Pose& pose) {
-    mavlink_message_t message;
-    const uint64_t usec = static_cast<uint64_t>(pose.timestamp_sec * 1e6);
-    float covariance[21] = {0.0f};
-    mavlink_msg_vision_position_estimate_pack(
-        system_id_,
-        component_id_,
+uint16_t encode_vision_position_estimate(const Pose& pose, uint8_t system_id, uint8_t component_id, uint8_t* buffer,
+                                         uint8_t sequence) {
+    mavlink_message_t message{};
+    // A private status instead of the library's global channel table: the sequence number comes
+    // from the caller and nothing is shared between vehicles or threads.
+    mavlink_status_t status{};
+    status.current_tx_seq = sequence;
+    const uint64_t usec   = static_cast<uint64_t>(pose.timestamp_sec * 1e6);
+    float covariance[21]  = {0.0f};
+    mavlink_msg_vision_position_estimate_pack_status(
+        system_id,
+        component_id,
+        &status,
         &message,
         usec,
         static_cast<float>(pose.x),
@@ -81,19 +105,26 @@ void MavlinkSender::send_pose(const Pose& pose) {
         static_cast<float>(pose.yaw),
         covariance,
         0);
+    return mavlink_msg_to_send_buffer(buffer, &message);
+}
 
-    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-    const uint16_t length = mavlink_msg_to_send_buffer(buffer, &message);
-    write_bytes(buffer, length);
+uint16_t MavlinkSender::send_pose(const Pose& pose, uint8_t system_id) {
+    uint8_t buffer[kMaxMavlinkFrameLength];
+    const uint16_t length =
+        encode_vision_position_estimate(pose, system_id, component_id_, buffer, tx_sequence_[system_id]++);
+    return write_bytes(buffer, length) ? length : 0;
 }
 
-void MavlinkSender::open_serial(const std::string& device, int baud_rate) {
-    fd_ = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
-    if (fd_ < 0) {
+MavlinkSender::Sink MavlinkSender::open_serial(const std::string& device, int baud_rate) {
+    Sink sink;
+    sink.name = device;
+    sink.fd   = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (sink.fd < 0) {
         throw std::runtime_error("Failed to open serial device: " + device + " error: " + std::strerror(errno));
     }
     termios tty{};
-    if (tcgetattr(fd_, &tty) != 0) {
+    if (tcgetattr(sink.fd, &tty) != 0) {
+        ::close(sink.fd);
         throw std::runtime_error("tcgetattr failed");
     }
     cfmakeraw(&tty);
@@ -102,35 +133,148 @@ void MavlinkSender::open_serial(const std::string& device, int baud_rate) {
     tty.c_cflag &= ~CSTOPB;
     tty.c_cflag &= ~CRTSCTS;
 
-    if (tcsetattr(fd_, TCSANOW, &tty) != 0) {
+    if (tcsetattr(sink.fd, TCSANOW, &tty) != 0) {
+        ::close(sink.fd);
         throw std::runtime_error("tcsetattr failed");
     }
+    return sink;
 }
 
-void MavlinkSender::open_udp(const std::string& target) {
-    auto [host, port] = parse_udp_target(target);
-    udp_socket_       = ::socket(AF_INET, SOCK_DGRAM, 0);
-    if (udp_socket_ < 0) {
+MavlinkSender::Sink MavlinkSender::open_udp(const std::string& target) {
+    Sink sink;
+    sink.name    = target;
+    sink.udp     = true;
+    sink.address = resolve_udp_endpoint(target);
+    sink.fd      = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (sink.fd < 0) {
         throw std::runtime_error("Failed to create UDP socket");
     }
-    std::memset(&udp_addr_, 0, sizeof(udp_addr_));
-    udp_addr_.sin_family = AF_INET;
-    udp_addr_.sin_port   = htons(port);
-    if (::inet_pton(AF_INET, host.c_str(), &udp_addr_.sin_addr) != 1) {
-        throw std::invalid_argument("Invalid UDP host: " + host);
+    return sink;
+}
+
+MavlinkSender::Sink MavlinkSender::open_mirror(const std::string& spec) {
+    const auto colon = spec.find(':');
+    const std::string type = spec.substr(0, colon);
+    const std::string rest = colon == std::string::npos ? std::string() : spec.substr(colon + 1);
+    Sink sink;
+    if (type == "udp") {
+        sink = open_udp(rest);
+    } else if (type == "serial") {
+        const auto baud = rest.rfind(':');
+        if (baud == std::string::npos) {
+            throw std::invalid_argument("Serial mirror must be serial:<device>:<baud>, got " + spec);
+        }
+        sink = open_serial(rest.substr(0, baud), std::stoi(rest.substr(baud + 1)));
+    } else {
+        throw std::invalid_argument("Mirror must be udp:<host>:<port> or serial:<device>:<baud>, got " + spec);
     }
+    sink.name   = spec;
+    sink.mirror = true;
+    return sink;
 }
 
-void MavlinkSender::write_bytes(const uint8_t* data, size_t length) {
-    if (use_udp_) {
-        if (::sendto(udp_socket_, data, length, 0, reinterpret_cast<sockaddr*>(&udp_addr_), sizeof(udp_addr_)) < 0) {
+size_t MavlinkSender::read_link(uint8_t* buffer, size_t capacity) {
+    for (;;) {
+        const ssize_t n = link_.udp ? ::recv(link_.fd, buffer, capacity, MSG_DONTWAIT) : ::read(link_.fd, buffer, capacity);
+        if (n >= 0) {
+            return static_cast<size_t>(n);
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // ECONNREFUSED: an ICMP error for an earlier datagram while the FC was not listening.
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED) {
+            return 0;
+        }
+        throw std::runtime_error(std::string("read failed: ") + std::strerror(errno));
+    }
+}
+
+bool MavlinkSender::write_bytes(const uint8_t* data, size_t length) {
+    VRPN_TRACE_SCOPE("write_bytes");
+    const bool accepted = write_sink(link_, data, length);
+    for (auto& mirror : mirrors_) {
+        write_sink(mirror, data, length);
+    }
+    return accepted;
+}
+
+bool MavlinkSender::write_sink(Sink& sink, const uint8_t* data, size_t length) {
+    if (!sink.udp) {
+        return write_serial(sink, data, length);
+    }
+    // Mirrors never wait for socket buffer space.
+    const int flags = sink.mirror ? MSG_DONTWAIT : 0;
+    if (::sendto(sink.fd, data, length, flags, reinterpret_cast<const sockaddr*>(&sink.address), sizeof(sink.address)) <
+        0) {
+        if (!sink.mirror) {
             throw std::runtime_error("sendto failed");
         }
-    } else {
-        if (::write(fd_, data, length) < 0) {
-            throw std::runtime_error("write failed");
+        sink.stats.frames_dropped += 1;
+        return false;
+    }
+    sink.stats.frames_sent += 1;
+    sink.stats.bytes_written += length;
+    return true;
+}
+
+bool MavlinkSender::flush_pending() {
+    bool empty = flush_sink(link_);
+    for (auto& mirror : mirrors_) {
+        empty = flush_sink(mirror) && empty;
+    }
+    return empty;
+}
+
+bool MavlinkSender::flush_sink(Sink& sink) {
+    while (!sink.pending.empty()) {
+        const ssize_t n = ::write(sink.fd, sink.pending.data(), sink.pending.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false;
+            }
+            if (!sink.mirror) {
+                throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+            }
+            sink.pending.clear();  // a broken mirror loses the tail; the FC link is unaffected
+            return true;
         }
+        sink.pending.erase(sink.pending.begin(), sink.pending.begin() + n);
+        sink.stats.bytes_written += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool MavlinkSender::write_serial(Sink& sink, const uint8_t* data, size_t length) {
+    // Never interleave a new frame with the tail of the previous one.
+    if (!flush_sink(sink)) {
+        sink.stats.frames_dropped += 1;
+        return false;
+    }
+
+    ssize_t n = 0;
+    do {
+        n = ::write(sink.fd, data, length);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || sink.mirror) {
+            sink.stats.frames_dropped += 1;
+            return false;
+        }
+        throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+    }
+
+    const size_t written = static_cast<size_t>(n);
+    sink.stats.frames_sent += 1;
+    sink.stats.bytes_written += written;
+    if (written < length) {
+        sink.stats.partial_writes += 1;
+        sink.pending.assign(data + written, data + length);
     }
+    return true;
 }
 
 }  // namespace receiver
@@ -0,0 +1,153 @@
+#include "receiver/PoseCapture.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace receiver {
+namespace {
+
+constexpr char kMagic[8] = {'V', 'R', 'P', 'N', 'C', 'A', 'P', '1'};
+constexpr uint32_t kVersion = 1;
+
+struct CaptureHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+static_assert(sizeof(CaptureHeader) == 16, "CaptureHeader layout is part of the file format");
+
+}  // namespace
+
+int64_t capture_clock_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+vrpn_TRACKERCB to_tracker_cb(const CaptureRecord& record) {
+    vrpn_TRACKERCB info{};
+    info.msg_time.tv_sec  = static_cast<decltype(info.msg_time.tv_sec)>(record.msg_sec);
+    info.msg_time.tv_usec = static_cast<decltype(info.msg_time.tv_usec)>(record.msg_usec);
+    info.sensor           = record.sensor;
+    for (int i = 0; i < 3; ++i) {
+        info.pos[i] = record.pos[i];
+    }
+    for (int i = 0; i < 4; ++i) {
+        info.quat[i] = record.quat[i];
+    }
+    return info;
+}
+
+CaptureWriter::CaptureWriter(const std::string& path) {
+    // O_EXCL: restarting with the same --capture must not wipe the previous session's recording.
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        throw std::runtime_error("Capture file " + path + " already exists; move it away or pick another path");
+    }
+    if (fd < 0 || !(file_ = ::fdopen(fd, "wb"))) {
+        const std::string reason = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to open capture file: " + path + " error: " + reason);
+    }
+    // Large stdio buffer so the VRPN callback only touches memory; the kernel sees ~1 write per 700 poses.
+    std::setvbuf(file_, nullptr, _IOFBF, 64 * 1024);
+
+    CaptureHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version     = kVersion;
+    header.record_size = sizeof(CaptureRecord);
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::fclose(file_);
+        throw std::runtime_error("Failed to write capture header: " + path);
+    }
+}
+
+CaptureWriter::~CaptureWriter() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+void CaptureWriter::append(const vrpn_TRACKERCB& info, int64_t arrival_us) {
+    if (failed_.load(std::memory_order_relaxed)) {
+        ++dropped_;
+        return;
+    }
+    CaptureRecord record;
+    record.arrival_us = arrival_us;
+    record.msg_sec    = info.msg_time.tv_sec;
+    record.msg_usec   = info.msg_time.tv_usec;
+    record.sensor     = info.sensor;
+    for (int i = 0; i < 3; ++i) {
+        record.pos[i] = info.pos[i];
+    }
+    for (int i = 0; i < 4; ++i) {
+        record.quat[i] = info.quat[i];
+    }
+    if (std::fwrite(&record, sizeof(record), 1, file_) != 1) {
+        ++dropped_;
+        fail("append");
+        return;
+    }
+    ++records_;
+}
+
+void CaptureWriter::flush() {
+    if (!failed() && std::fflush(file_) != 0) {
+        fail("flush");
+    }
+}
+
+void CaptureWriter::fail(const char* what) {
+    // Records already buffered by stdio may be lost with the failing block; records() over-counts
+    // by at most one buffer (~700 records).
+    error_ = std::string(what) + " failed: " + std::strerror(errno);
+    failed_.store(true, std::memory_order_release);
+}
+
+CaptureReader::CaptureReader(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open capture file: " + path + " error: " + std::strerror(errno));
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CaptureHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Capture file is truncated: " + path);
+    }
+    mapping_size_ = static_cast<size_t>(st.st_size);
+    mapping_      = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::runtime_error("mmap failed for capture file: " + path);
+    }
+
+    const auto* header = static_cast<const CaptureHeader*>(mapping_);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+        header->record_size != sizeof(CaptureRecord)) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        throw std::runtime_error("Not a vrpn_receiver capture file: " + path);
+    }
+    ::madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+
+    // A capture cut short by a crash keeps every complete record; the torn tail is ignored.
+    records_ = reinterpret_cast<const CaptureRecord*>(static_cast<const char*>(mapping_) + sizeof(CaptureHeader));
+    count_   = (mapping_size_ - sizeof(CaptureHeader)) / sizeof(CaptureRecord);
+}
+
+CaptureReader::~CaptureReader() {
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+}
+
+}  // namespace receiver
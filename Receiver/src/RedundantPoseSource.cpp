@@ -0,0 +1,208 @@
+#include "receiver/RedundantPoseSource.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace receiver {
+namespace {
+
+// VRPN stamps samples in microseconds; two sources deliver the same sample if they agree to that.
+constexpr double kSameSample = 0.5e-6;
+// A source that stays live but stops delivering should not grow its backlog without bound.
+constexpr size_t kMaxPending = 256;
+
+double seconds(PoseSource::clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+void record_lag(SourceStats& stats, double lag_s) {
+    ++stats.lag_samples;
+    stats.lag_sum_s += lag_s;
+    stats.lag_max_s = std::max(stats.lag_max_s, lag_s);
+}
+
+}  // namespace
+
+RedundantPoseSource::RedundantPoseSource(std::vector<std::unique_ptr<PoseSource>> sources,
+                                         double primary_tolerance_s)
+    : tolerance_s_(std::max(primary_tolerance_s, 0.0)) {
+    if (sources.empty()) {
+        throw std::invalid_argument("RedundantPoseSource needs at least one source");
+    }
+    for (auto& source : sources) {
+        Entry entry;
+        entry.source = std::move(source);
+        sources_.push_back(std::move(entry));
+    }
+}
+
+void RedundantPoseSource::set_capture(CaptureWriter* writer) {
+    sources_.front().source->set_capture(writer);
+}
+
+std::optional<Pose> RedundantPoseSource::latest_pose() const {
+    if (!have_pose_) {
+        return std::nullopt;
+    }
+    return last_pose_;
+}
+
+void RedundantPoseSource::account(Entry& entry, const Pose& pose, clock::time_point arrival) {
+    auto& stats = entry.stats;
+    ++stats.received;
+    const double wall_now =
+        std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const double latency = wall_now - pose.timestamp_sec;
+    stats.latency_sum_s += latency;
+    stats.latency_max_s = std::max(stats.latency_max_s, latency);
+
+    // Samples another source already forwarded: older ones this source skipped are lost on it, the
+    // matching one tells how far behind the first arrival it was.
+    auto& pending = entry.pending;
+    while (!pending.empty() && pending.front().timestamp_sec < pose.timestamp_sec - kSameSample) {
+        ++stats.missed;
+        pending.pop_front();
+    }
+    if (!pending.empty() && std::abs(pending.front().timestamp_sec - pose.timestamp_sec) <= kSameSample) {
+        record_lag(stats, seconds(arrival - pending.front().arrival));
+        pending.pop_front();
+    }
+}
+
+void RedundantPoseSource::forward(size_t index, const Pose& pose, clock::time_point arrival) {
+    const double stamp = pose.timestamp_sec;
+
+    // Every source whose newest sample is this one is matched now, the ones still behind later.
+    clock::time_point first_arrival = arrival;
+    for (const auto& entry : sources_) {
+        const auto latest = entry.source->latest_pose();
+        if (entry.live && latest && std::abs(latest->timestamp_sec - stamp) <= kSameSample) {
+            first_arrival = std::min(first_arrival, entry.seen);
+        }
+    }
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        Entry& entry = sources_[i];
+        if (i == index) {
+            record_lag(entry.stats, seconds(arrival - first_arrival));
+            continue;
+        }
+        if (!entry.live) {
+            continue;
+        }
+        const auto latest = entry.source->latest_pose();
+        if (std::abs(latest->timestamp_sec - stamp) <= kSameSample) {
+            record_lag(entry.stats, seconds(entry.seen - first_arrival));
+        } else if (latest->timestamp_sec < stamp) {
+            entry.pending.push_back(Pending{stamp, first_arrival});
+            if (entry.pending.size() > kMaxPending) {
+                ++entry.stats.missed;
+                entry.pending.pop_front();
+            }
+        }
+    }
+
+    if (have_pose_ && index != active_) {
+        ++switches_;
+    }
+    active_         = index;
+    last_pose_      = pose;
+    last_pose_time_ = arrival;
+    have_pose_      = true;
+    ++sources_[index].stats.selected;
+    ++stats_.poses;
+}
+
+bool RedundantPoseSource::spin_once() {
+    return spin_once(clock::now());
+}
+
+bool RedundantPoseSource::spin_once(clock::time_point now) {
+    bool any_live = false;
+    for (auto& entry : sources_) {
+        entry.fresh.reset();
+        entry.live = entry.source->spin_once() && entry.source->latest_pose().has_value();
+        if (!entry.live) {
+            // Whatever it missed while down shows up in its disconnect time, not as loss.
+            entry.pending.clear();
+            continue;
+        }
+        any_live           = true;
+        const auto arrival = entry.source->last_pose_time();
+        if (arrival == entry.seen) {
+            continue;
+        }
+        entry.seen  = arrival;
+        entry.fresh = entry.source->latest_pose();
+        account(entry, *entry.fresh, arrival);
+    }
+
+    // Candidates are the samples that would move the output forward.
+    const auto is_candidate = [&](size_t i) {
+        const auto& fresh = sources_[i].fresh;
+        return fresh && (!have_pose_ || fresh->timestamp_sec > last_pose_.timestamp_sec);
+    };
+
+    // The primary, then the active source, forward without waiting.
+    size_t chosen = sources_.size();
+    if (is_candidate(0) &&
+        (!is_candidate(active_) ||
+         sources_[0].fresh->timestamp_sec >= sources_[active_].fresh->timestamp_sec - kSameSample)) {
+        chosen = 0;
+    } else if (is_candidate(active_)) {
+        chosen = active_;
+    }
+
+    // Anything newer from elsewhere waits for the active source to miss it.
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        if (i == chosen || !is_candidate(i) ||
+            (holding_ && sources_[i].fresh->timestamp_sec <= held_pose_.timestamp_sec)) {
+            continue;
+        }
+        if (!holding_) {
+            holding_    = true;
+            held_since_ = sources_[i].seen;
+        }
+        held_         = i;
+        held_pose_    = *sources_[i].fresh;
+        held_arrival_ = sources_[i].seen;
+    }
+
+    if (chosen != sources_.size()) {
+        forward(chosen, *sources_[chosen].fresh, sources_[chosen].seen);
+    } else if (holding_) {
+        const bool overdue = seconds(now - held_since_) >= tolerance_s_;
+        if (!have_pose_ || !sources_[active_].live || overdue) {
+            chosen = held_;
+            forward(held_, held_pose_, held_arrival_);
+        }
+    }
+    if (holding_ && have_pose_ && held_pose_.timestamp_sec <= last_pose_.timestamp_sec + kSameSample) {
+        holding_ = false;
+    }
+
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        const auto& fresh = sources_[i].fresh;
+        if (i != chosen && fresh && fresh->timestamp_sec <= last_pose_.timestamp_sec) {
+            ++sources_[i].stats.late;
+        }
+    }
+
+    const auto& active        = sources_[active_].source->stats();
+    stats_.disconnects        = 0;
+    stats_.reconnect_attempts = 0;
+    stats_.total_disconnect_s = 0.0;
+    stats_.max_first_pose_s   = 0.0;
+    stats_.last_disconnect_s  = active.last_disconnect_s;
+    stats_.last_first_pose_s  = active.last_first_pose_s;
+    for (const auto& entry : sources_) {
+        const auto& source = entry.source->stats();
+        stats_.disconnects += source.disconnects;
+        stats_.reconnect_attempts += source.reconnect_attempts;
+        stats_.total_disconnect_s += source.total_disconnect_s;
+        stats_.max_first_pose_s = std::max(stats_.max_first_pose_s, source.max_first_pose_s);
+    }
+    return any_live;
+}
+
+}  // namespace receiver
@@ -0,0 +1,124 @@
+#include "receiver/ShmPoseSource.h"
+
+#include "receiver/PoseCapture.h"
+#include "receiver/TrackerClient.h"
+#include "vrpn_common/Trace.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace receiver {
+
+namespace {
+
+// Retry period for a missing segment, and how long a slot may stay silent before we check whether
+// the writer re-created the segment.
+constexpr auto kCheckInterval = std::chrono::milliseconds(250);
+
+}  // namespace
+
+ShmPoseSource::ShmPoseSource(const std::string& segment, const std::string& tracker)
+    : segment_(segment), tracker_(tracker) {
+    // Only a tracker missing at startup (or from a runtime `add`) is an error; later it is retried.
+    if (!attach(clock::now()) && tracker_missing_) {
+        throw std::runtime_error("Tracker " + tracker_ + " is not published in shared-memory segment " + segment_);
+    }
+}
+
+bool ShmPoseSource::spin_once() {
+    return spin_once(clock::now());
+}
+
+bool ShmPoseSource::spin_once(clock::time_point now) {
+    VRPN_TRACE_SCOPE("shm_spin_once");
+    if (!reader_) {
+        if (now < next_check_) {
+            return false;
+        }
+        ++stats_.reconnect_attempts;
+        if (!attach(now)) {
+            return false;
+        }
+    }
+
+    vrpn_common::SharedPoseSample sample;
+    if (reader_->read(slot_, sample, last_sequence_)) {
+        vrpn_TRACKERCB info{};
+        info.msg_time.tv_sec  = static_cast<decltype(info.msg_time.tv_sec)>(sample.time_sec);
+        info.msg_time.tv_usec = static_cast<decltype(info.msg_time.tv_usec)>(sample.time_usec);
+        info.sensor           = 0;
+        std::copy(sample.pos, sample.pos + 3, info.pos);
+        std::copy(sample.quat, sample.quat + 4, info.quat);
+        if (capture_) {
+            capture_->append(info, capture_clock_us());
+        }
+        last_pose_      = from_tracker_cb(info);
+        last_pose_time_ = now;
+        last_change_    = now;
+        ++stats_.poses;
+
+        if (!have_pose_) {
+            stats_.last_first_pose_s = std::chrono::duration<double>(now - attached_at_).count();
+            stats_.max_first_pose_s  = std::max(stats_.max_first_pose_s, stats_.last_first_pose_s);
+            if (disconnected_at_) {
+                stats_.last_disconnect_s = std::chrono::duration<double>(now - *disconnected_at_).count();
+                stats_.total_disconnect_s += stats_.last_disconnect_s;
+                disconnected_at_.reset();
+            }
+            have_pose_ = true;
+        }
+        return true;
+    }
+
+    // Checking for a re-created segment costs syscalls, so only while the slot is quiet.
+    if (now - last_change_ > kCheckInterval && now >= next_check_) {
+        next_check_ = now + kCheckInterval;
+        if (reader_->replaced()) {
+            detach(now);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<Pose> ShmPoseSource::latest_pose() const {
+    if (!have_pose_) {
+        return std::nullopt;
+    }
+    return last_pose_;
+}
+
+bool ShmPoseSource::attach(clock::time_point now) {
+    next_check_      = now + kCheckInterval;
+    tracker_missing_ = false;
+    try {
+        reader_ = std::make_unique<vrpn_common::SharedPoseReader>(segment_);
+    } catch (const std::runtime_error&) {
+        return false;  // sender not up yet; retried from spin_once
+    }
+    const int slot = reader_->find(tracker_);
+    if (slot < 0) {
+        // A sender restarted with another tracker list: retried like a missing segment, since
+        // throwing here would escape the VRPN thread.
+        reader_.reset();
+        tracker_missing_ = true;
+        return false;
+    }
+    slot_          = static_cast<size_t>(slot);
+    last_sequence_ = 0;
+    attached_at_   = now;
+    last_change_   = now;
+    return true;
+}
+
+void ShmPoseSource::detach(clock::time_point now) {
+    if (have_pose_) {
+        ++stats_.disconnects;
+        disconnected_at_ = now;
+    }
+    reader_.reset();
+    have_pose_  = false;
+    next_check_ = now;
+}
+
+}  // namespace receiver
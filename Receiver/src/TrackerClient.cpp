@@ -1,13 +1,16 @@
 #include "receiver/TrackerClient.h"
 
+#include "receiver/PoseCapture.h"
+#include "vrpn_common/Trace.h"
+
 #include <vrpn_Tracker.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <stdexcept>
 
 namespace receiver {
-namespace {
 
 Pose from_tracker_cb(const vrpn_TRACKERCB& info) {
     Pose pose;
@@ -16,32 +19,33 @@ Pose from_tracker_cb(const vrpn_TRACKERCB& info) {
     pose.y             = info.pos[1];
     pose.z             = info.pos[2];
 
-    const double qx = info.quat[0];
-    const double qy = info.quat[1];
-    const double qz = info.quat[2];
-    const double qw = info.quat[3];
+    pose.qx            = info.quat[0];
+    pose.qy            = info.quat[1];
+    pose.qz            = info.quat[2];
+    pose.qw            = info.quat[3];
+    quaternion_to_euler(pose.qx, pose.qy, pose.qz, pose.qw, pose.roll, pose.pitch, pose.yaw);
+    return pose;
+}
 
+void quaternion_to_euler(double qx, double qy, double qz, double qw, double& roll, double& pitch, double& yaw) {
     const double sinr_cosp = 2.0 * (qw * qx + qy * qz);
     const double cosr_cosp = 1.0 - 2.0 * (qx * qx + qy * qy);
-    pose.roll              = std::atan2(sinr_cosp, cosr_cosp);
+    roll                   = std::atan2(sinr_cosp, cosr_cosp);
 
     const double sinp = 2.0 * (qw * qy - qz * qx);
     if (std::abs(sinp) >= 1.0) {
-        pose.pitch = std::copysign(M_PI / 2.0, sinp);
+        pitch = std::copysign(M_PI / 2.0, sinp);
     } else {
-        pose.pitch = std::asin(sinp);
+        pitch = std::asin(sinp);
     }
 
     const double siny_cosp = 2.0 * (qw * qz + qx * qy);
     const double cosy_cosp = 1.0 - 2.0 * (qy * qy + qz * qz);
-    pose.yaw               = std::atan2(siny_cosp, cosy_cosp);
-    return pose;
+    yaw                    = std::atan2(siny_cosp, cosy_cosp);
 }
 
-}  // namespace
-
-TrackerClient::TrackerClient(const std::string& address)
-    : address_(address) {
+TrackerClient::TrackerClient(const std::string& address, const ReconnectOptions& reconnect)
+    : address_(address), reconnect_(reconnect) {
     create_tracker();
 }
 
@@ -50,15 +54,20 @@ TrackerClient::~TrackerClient() {
 }
 
 bool TrackerClient::spin_once() {
-    if (!tracker_) {
+    VRPN_TRACE_SCOPE("spin_once");
+    const auto now = clock::now();
+    if (state_ == State::kBackoff) {
+        if (now < next_attempt_) {
+            return false;
+        }
+        ++stats_.reconnect_attempts;
         create_tracker();
-        return tracker_ != nullptr;
     }
     tracker_->mainloop();
     if (auto* conn = tracker_->connectionPtr()) {
         conn->mainloop();
-        if (active_ && !conn->doing_okay()) {
-            destroy_tracker();
+        if (!conn->doing_okay()) {
+            enter_backoff(now);
             return false;
         }
     }
@@ -73,10 +82,29 @@ std::optional<Pose> TrackerClient::latest_pose() const {
 }
 
 void VRPN_CALLBACK TrackerClient::handle_tracker(void* userdata, const vrpn_TRACKERCB info) {
+    VRPN_TRACE_SCOPE("tracker_callback");
     auto* self = static_cast<TrackerClient*>(userdata);
-    self->last_pose_ = from_tracker_cb(info);
-    self->have_pose_ = true;
-    self->active_    = true;
+    if (self->capture_) {
+        self->capture_->append(info, capture_clock_us());
+    }
+    const auto now        = clock::now();
+    self->last_pose_      = from_tracker_cb(info);
+    self->last_pose_time_ = now;
+    self->have_pose_      = true;
+    ++self->stats_.poses;
+
+    if (self->state_ != State::kStreaming) {
+        auto& stats             = self->stats_;
+        stats.last_first_pose_s = std::chrono::duration<double>(now - self->attempt_started_).count();
+        stats.max_first_pose_s  = std::max(stats.max_first_pose_s, stats.last_first_pose_s);
+        if (self->disconnected_at_) {
+            stats.last_disconnect_s = std::chrono::duration<double>(now - *self->disconnected_at_).count();
+            stats.total_disconnect_s += stats.last_disconnect_s;
+            self->disconnected_at_.reset();
+        }
+        self->backoff_step_ = 0;
+        self->state_        = State::kStreaming;
+    }
 }
 
 void TrackerClient::create_tracker() {
@@ -86,8 +114,8 @@ void TrackerClient::create_tracker() {
         throw std::runtime_error("Failed to create vrpn_Tracker_Remote");
     }
     tracker_->register_change_handler(this, &TrackerClient::handle_tracker);
-    have_pose_ = false;
-    active_    = false;
+    state_           = State::kConnecting;
+    attempt_started_ = clock::now();
 }
 
 void TrackerClient::destroy_tracker() {
@@ -97,7 +125,26 @@ void TrackerClient::destroy_tracker() {
         tracker_ = nullptr;
     }
     have_pose_ = false;
-    active_    = false;
+}
+
+void TrackerClient::enter_backoff(clock::time_point now) {
+    if (state_ == State::kStreaming) {
+        ++stats_.disconnects;
+        disconnected_at_ = now;
+    }
+    destroy_tracker();
+
+    // Exponential backoff, capped, with symmetric jitter so many receivers do not retry in lockstep.
+    double delay = reconnect_.initial_backoff_s * std::pow(2.0, backoff_step_);
+    delay        = std::min(delay, reconnect_.max_backoff_s);
+    std::uniform_real_distribution<double> jitter(-reconnect_.jitter_fraction, reconnect_.jitter_fraction);
+    delay *= 1.0 + jitter(rng_);
+    if (delay < reconnect_.max_backoff_s) {
+        ++backoff_step_;
+    }
+
+    next_attempt_ = now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(delay));
+    state_        = State::kBackoff;
 }
 
 }  // namespace receiver
@@ -0,0 +1,205 @@
+#include "receiver/VehicleRoster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace receiver {
+namespace {
+
+double parse_rate(const std::string& text) {
+    const double value = parse_number(text, "rate");
+    if (value <= 0.0) {
+        throw std::invalid_argument("rate must be positive, got '" + text + "'");
+    }
+    return value;
+}
+
+}  // namespace
+
+VehicleSpec parse_vehicle_spec(const std::string& text) {
+    const auto first = text.find(':');
+    if (first == std::string::npos || first == 0) {
+        throw std::invalid_argument("--vehicle expects <tracker>:<sysid>[:<weight>], got '" + text + "'");
+    }
+    VehicleSpec spec;
+    spec.tracker      = text.substr(0, first);
+    const auto second = text.find(':', first + 1);
+    spec.system_id    = parse_system_id(text.substr(first + 1, second - first - 1));
+    if (second != std::string::npos) {
+        spec.weight = parse_number(text.substr(second + 1), "weight");
+    }
+    return spec;
+}
+
+double parse_number(const std::string& text, const char* what) {
+    try {
+        size_t used        = 0;
+        const double value = std::stod(text, &used);
+        if (used == text.size()) {
+            return value;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument(std::string("bad ") + what + " '" + text + "'");
+}
+
+uint8_t parse_system_id(const std::string& text) {
+    const double value = parse_number(text, "sysid");
+    if (value < 1.0 || value > 255.0 || value != std::floor(value)) {
+        throw std::invalid_argument("sysid must be 1-255, got '" + text + "'");
+    }
+    return static_cast<uint8_t>(value);
+}
+
+VehicleRoster::VehicleRoster(LinkScheduler& scheduler, double default_rate_hz, Hooks hooks)
+    : scheduler_(scheduler), default_rate_hz_(default_rate_hz), hooks_(std::move(hooks)) {}
+
+void VehicleRoster::check_unique(const VehicleSpec& spec, size_t except) const {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (i == except || !slots_[i].active) {
+            continue;
+        }
+        if (slots_[i].spec.tracker == spec.tracker) {
+            throw std::invalid_argument(spec.tracker + " is already forwarded");
+        }
+        // The FC and GCS tell vehicles apart by sysid alone; two trackers on one would interleave.
+        if (slots_[i].spec.system_id == spec.system_id) {
+            throw std::invalid_argument("sysid " + std::to_string(spec.system_id) + " is already used by " +
+                                        slots_[i].spec.tracker);
+        }
+    }
+}
+
+size_t VehicleRoster::add(const VehicleSpec& spec, double requested_hz) {
+    check_unique(spec, slots_.size());
+    const size_t slot = scheduler_.add_vehicle(requested_hz, spec.weight);
+    if (slot >= slots_.size()) {
+        slots_.resize(slot + 1);
+    }
+    if (hooks_.added) {
+        try {
+            hooks_.added(slot, spec);
+        } catch (...) {
+            scheduler_.remove_vehicle(slot);
+            throw;
+        }
+    }
+    slots_[slot].spec   = spec;
+    slots_[slot].active = true;
+    slots_[slot].added  = clock::now();
+    return slot;
+}
+
+void VehicleRoster::remove(size_t slot) {
+    if (hooks_.removed) {
+        hooks_.removed(slot);
+    }
+    scheduler_.remove_vehicle(slot);
+    slots_[slot].active = false;
+}
+
+void VehicleRoster::set_system_id(size_t slot, uint8_t system_id) {
+    VehicleSpec changed = slots_[slot].spec;
+    changed.system_id   = system_id;
+    check_unique(changed, slot);
+    slots_[slot].spec = changed;
+}
+
+size_t VehicleRoster::find(const std::string& tracker) const {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].active && slots_[i].spec.tracker == tracker) {
+            return i;
+        }
+    }
+    throw std::invalid_argument(tracker + " is not forwarded");
+}
+
+std::string VehicleRoster::allocation_summary() const {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    const char* separator = "";
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].active) {
+            out << separator << slots_[i].spec.tracker << " " << scheduler_.vehicle(i).allocated_hz << " Hz";
+            separator = ", ";
+        }
+    }
+    return out.str();
+}
+
+std::string VehicleRoster::stats() const {
+    std::ostringstream reply;
+    reply.setf(std::ios::fixed);
+    reply.precision(1);
+    const auto now = clock::now();
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (!slots_[i].active) {
+            continue;
+        }
+        const auto& share = scheduler_.vehicle(i);
+        const double age  = std::max(std::chrono::duration<double>(now - slots_[i].added).count(), 1e-3);
+        reply << slots_[i].spec.tracker << " sysid=" << int(slots_[i].spec.system_id) << " weight=" << share.weight
+              << " requested=" << share.requested_hz << " allocated=" << share.allocated_hz
+              << " effective=" << share.sent / age << " sent=" << share.sent << " deferred=" << share.deferred
+              << " dropped=" << share.dropped;
+        if (hooks_.describe) {
+            reply << hooks_.describe(i);
+        }
+        reply << "\n";
+    }
+    if (hooks_.link_summary) {
+        reply << hooks_.link_summary();
+    }
+    reply << "ok\n";
+    return reply.str();
+}
+
+std::string VehicleRoster::handle(const std::string& line) {
+    std::istringstream words(line);
+    const std::vector<std::string> args{std::istream_iterator<std::string>(words),
+                                        std::istream_iterator<std::string>()};
+    try {
+        const std::string command = args.empty() ? std::string() : args.front();
+        if (command == "add" && args.size() >= 3 && args.size() <= 5) {
+            const VehicleSpec spec{args[1], parse_system_id(args[2]),
+                                   args.size() > 3 ? parse_number(args[3], "weight") : 1.0};
+            add(spec, args.size() > 4 ? parse_rate(args[4]) : default_rate_hz_);
+        } else if (command == "remove" && args.size() == 2) {
+            remove(find(args[1]));
+        } else if (command == "rate" && args.size() == 3) {
+            const double requested = parse_rate(args[2]);
+            if (args[1] == "all") {
+                default_rate_hz_ = requested;  // and the default for later adds
+                for (size_t i = 0; i < slots_.size(); ++i) {
+                    if (slots_[i].active) {
+                        scheduler_.set_rate(i, requested);
+                    }
+                }
+            } else {
+                scheduler_.set_rate(find(args[1]), requested);
+            }
+        } else if (command == "sysid" && args.size() == 3) {
+            set_system_id(find(args[1]), parse_system_id(args[2]));
+        } else if (command == "stats" && args.size() == 1) {
+            return stats();
+        } else if (command == "help") {
+            return "add <tracker> <sysid> [weight] [rate]\n"
+                   "remove <tracker>\n"
+                   "rate <tracker|all> <Hz>\n"
+                   "sysid <tracker> <id>\n"
+                   "stats\n"
+                   "ok\n";
+        } else {
+            throw std::invalid_argument("cannot parse '" + line + "', try help");
+        }
+    } catch (const std::exception& ex) {
+        return std::string("error: ") + ex.what() + "\n";
+    }
+    return "ok " + allocation_summary() + "\n";
+}
+
+}  // namespace receiver
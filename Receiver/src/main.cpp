@@ -1,15 +1,33 @@
+#include "receiver/ControlSocket.h"
+#include "receiver/FrameTransform.h"
+#include "receiver/LinkScheduler.h"
+#include "receiver/MavlinkRelay.h"
 #include "receiver/MavlinkSender.h"
+#include "receiver/PoseCapture.h"
+#include "receiver/PoseMailbox.h"
+#include "receiver/RedundantPoseSource.h"
+#include "receiver/ShmPoseSource.h"
 #include "receiver/TrackerClient.h"
+#include "receiver/VehicleRoster.h"
+#include "vrpn_common/Realtime.h"
+#include "vrpn_common/Trace.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <csignal>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <sstream>
 #include <string>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 namespace {
 volatile std::sig_atomic_t g_should_exit = 0;
@@ -33,21 +51,73 @@ const char* program_name(const char* exe) {
     return base;
 }
 
+void log_realtime(const char* thread_name, const vrpn_common::RealtimeReport& report) {
+    if (!report.message.empty()) {
+        std::cerr << "[vrpn_receiver] " << thread_name << ": " << report.message << "\n";
+    }
+}
+
+struct Vehicle {
+    std::string tracker;
+    std::string address;
+    std::unique_ptr<receiver::PoseSource> source;
+    receiver::RedundantPoseSource* redundant = nullptr;  // same object as `source` when --source repeats
+    std::vector<std::string> source_addresses;
+    std::vector<uint64_t> source_disconnects;
+    std::vector<bool> source_waiting;
+    uint64_t reported_switches = 0;
+    receiver::PoseMailbox mailbox;
+    uint64_t reported_disconnects = 0;
+    bool waiting_for_pose         = false;
+    bool stale                    = false;
+    uint64_t stale_ticks          = 0;
+    std::chrono::steady_clock::time_point added;
+    // Copy of source->stats() for the control socket; the source itself belongs to the polling thread.
+    std::mutex stats_mutex;
+    receiver::TrackerStats stats;
+};
+
 void print_usage(const char* exe) {
     const char* prog = program_name(exe);
-    std::cout << "Usage: " << prog << " --tracker <name> [options]\n";
+    std::cout << "Usage: " << prog << " --tracker <name> | --vehicle <tracker:sysid[:weight]>... [options]\n";
     std::cout << "Options:\n"
               << "  --tracker <name>        Tracker name (e.g. uav0)\n"
               << "  --host <addr>           VRPN host (default 127.0.0.1)\n"
               << "  --port <port>           VRPN port (default 3883)\n"
-              << "  --rate <Hz>             Publish rate (default 50)\n"
+              << "  --source host:port      VRPN server carrying the trackers; repeat for redundant servers, first is primary\n"
+              << "  --primary-tolerance <ms>  Wait this long for the current source before switching (default 5)\n"
+              << "  --shm <name>            Read the tracker from the sender's shared-memory table instead of VRPN\n"
+              << "  --vehicle t:sysid[:w]   Forward tracker t as MAVLink system sysid with weight w (repeatable)\n"
+              << "  --rate <Hz>             Publish rate per vehicle (default 50)\n"
+              << "  --link-budget <B/s>     Bytes/s the vehicles share, 0 = unlimited (default: 90% of baud/10 on serial)\n"
+              << "  --status-interval <s>   Print each vehicle's effective rate every <s> seconds (default off)\n"
               << "  --link <serial|udp>     Output link type (default serial)\n"
               << "  --device <path>         Serial device (default /dev/ttyUSB0)\n"
               << "  --baud <rate>           Serial baud rate (default 921600)\n"
               << "  --udp-target host:port  UDP target (default 127.0.0.1:14550)\n"
+              << "  --mirror <spec>         Also send every frame to udp:host:port or serial:dev:baud (repeatable)\n"
+              << "  --gcs host:port         Relay FC telemetry to this GCS and its replies back to the FC (repeatable)\n"
+              << "  --gcs-bind <port>       Local UDP port the GCS endpoints talk to (default: ephemeral)\n"
               << "  --sysid <id>            MAVLink system id (default 1)\n"
               << "  --compid <id>           MAVLink component id (default 1)\n"
+              << "  --frame <none|enu|yup>  Mocap frame converted to NED/FRD (default none)\n"
+              << "  --yaw-offset <deg>      Heading of mocap north relative to NED north (default 0)\n"
+              << "  --origin-offset x,y,z   NED offset added after rotation, metres (default 0,0,0)\n"
+              << "  --body-offset x,y,z     FRD lever arm from rigid-body pivot to vehicle origin (default 0,0,0)\n"
               << "  --log-poses             Print forwarded poses (default disabled)\n"
+              << "  --capture <file>        Record every raw tracker report to a new binary capture; one vehicle\n"
+              << "                          only, not overwritten if it exists, runtime adds are not recorded\n"
+              << "  --stale-timeout <s>     Stop forwarding when the newest pose is older, 0 disables (default 0.5)\n"
+              << "  --reconnect-min <s>     First reconnect delay, doubled per failure (default 0.05)\n"
+              << "  --reconnect-max <s>     Reconnect delay cap (default 2.0)\n"
+              << "  --rt-policy <other|fifo|rr>  Scheduling policy for both threads (default other)\n"
+              << "  --rt-priority <N>       Real-time priority for fifo/rr (default 50)\n"
+              << "  --rt-cpu-vrpn <N>       Pin the VRPN thread to CPU N\n"
+              << "  --rt-cpu-send <N>       Pin the send loop to CPU N\n"
+              << "  --rt-mlock              Lock all memory with mlockall\n"
+              << "  --rt-jitter-test <s>    Measure send-loop wake-up jitter without and with the profile, then exit\n"
+              << "  --trace <file>          Write a Chrome trace at exit and on SIGUSR1 (tracing builds only)\n"
+              << "  --control <path>        Unix socket taking add/remove/rate/sysid/stats commands while running\n"
               << "\nExamples:\n"
               << "  " << prog
               << " --tracker uav5 --host 192.168.1.50 --port 4000 --rate 40"
@@ -55,7 +125,15 @@ void print_usage(const char* exe) {
                  " --sysid 1 --compid 196 --log-poses\n"
               << "  " << prog
               << " --tracker uav0 --host 127.0.0.1 --port 3883 --rate 60"
-                 " --link udp --udp-target 127.0.0.1:14550 --sysid 42 --compid 200 --log-poses\n";
+                 " --link udp --udp-target 127.0.0.1:14550 --sysid 42 --compid 200 --log-poses\n"
+              << "  " << prog
+              << " --tracker uav0 --link serial --device /dev/ttyACM0 --baud 921600"
+                 " --gcs 192.168.1.10:14550 --gcs-bind 14551\n"
+              << "  " << prog
+              << " --tracker uav0 --source 192.168.1.50:3883 --source 192.168.1.51:3883 --link udp\n"
+              << "  " << prog
+              << " --vehicle uav0:1 --vehicle uav1:2 --vehicle uav2:3:2"
+                 " --link serial --device /dev/ttyUSB0 --baud 57600 --status-interval 5\n";
 }
 
 }  // namespace
@@ -67,9 +145,27 @@ int main(int argc, char** argv) {
     std::string tracker_name;
     std::string host = "127.0.0.1";
     int port         = 3883;
+    std::string shm_name;
+    std::vector<std::string> sources;
+    double primary_tolerance_ms = 5.0;
     double rate_hz   = 50.0;
     receiver::MavlinkOptions link_opts;
+    receiver::FrameTransformOptions frame_opts;
     bool log_poses = false;
+    std::string capture_path;
+    double stale_timeout_s = 0.5;
+    receiver::ReconnectOptions reconnect_opts;
+    vrpn_common::RealtimeOptions rt_opts;
+    std::vector<receiver::VehicleSpec> vehicle_specs;
+    std::vector<std::string> gcs_endpoints;
+    int gcs_bind_port = 0;
+    double link_budget       = -1.0;  // < 0: derive from the link type
+    double status_interval_s = 0.0;
+    int rt_cpu_vrpn      = -1;
+    int rt_cpu_send      = -1;
+    double jitter_test_s = 0.0;
+    std::string trace_path;
+    std::string control_path;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -88,8 +184,25 @@ int main(int argc, char** argv) {
             host = require_value("--host");
         } else if (arg == "--port") {
             port = std::stoi(require_value("--port"));
+        } else if (arg == "--source") {
+            sources.push_back(require_value("--source"));
+        } else if (arg == "--primary-tolerance") {
+            primary_tolerance_ms = std::stod(require_value("--primary-tolerance"));
+        } else if (arg == "--shm") {
+            shm_name = require_value("--shm");
+        } else if (arg == "--vehicle") {
+            try {
+                vehicle_specs.push_back(receiver::parse_vehicle_spec(require_value("--vehicle")));
+            } catch (const std::exception& ex) {
+                std::cerr << ex.what() << "\n";
+                return 1;
+            }
         } else if (arg == "--rate") {
             rate_hz = std::stod(require_value("--rate"));
+        } else if (arg == "--link-budget") {
+            link_budget = std::stod(require_value("--link-budget"));
+        } else if (arg == "--status-interval") {
+            status_interval_s = std::stod(require_value("--status-interval"));
         } else if (arg == "--link") {
             link_opts.link_type = require_value("--link");
         } else if (arg == "--device") {
@@ -98,12 +211,50 @@ int main(int argc, char** argv) {
             link_opts.baud_rate = std::stoi(require_value("--baud"));
         } else if (arg == "--udp-target") {
             link_opts.udp_target = require_value("--udp-target");
+        } else if (arg == "--mirror") {
+            link_opts.mirrors.push_back(require_value("--mirror"));
+        } else if (arg == "--gcs") {
+            gcs_endpoints.push_back(require_value("--gcs"));
+        } else if (arg == "--gcs-bind") {
+            gcs_bind_port = std::stoi(require_value("--gcs-bind"));
         } else if (arg == "--sysid") {
             link_opts.system_id = static_cast<uint8_t>(std::stoi(require_value("--sysid")));
         } else if (arg == "--compid") {
             link_opts.component_id = static_cast<uint8_t>(std::stoi(require_value("--compid")));
+        } else if (arg == "--frame") {
+            frame_opts.frame = receiver::parse_mocap_frame(require_value("--frame"));
+        } else if (arg == "--yaw-offset") {
+            frame_opts.yaw_offset_rad = std::stod(require_value("--yaw-offset")) * M_PI / 180.0;
+        } else if (arg == "--origin-offset") {
+            frame_opts.origin_offset = receiver::parse_vector3(require_value("--origin-offset"));
+        } else if (arg == "--body-offset") {
+            frame_opts.body_offset = receiver::parse_vector3(require_value("--body-offset"));
         } else if (arg == "--log-poses") {
             log_poses = true;
+        } else if (arg == "--capture") {
+            capture_path = require_value("--capture");
+        } else if (arg == "--stale-timeout") {
+            stale_timeout_s = std::stod(require_value("--stale-timeout"));
+        } else if (arg == "--reconnect-min") {
+            reconnect_opts.initial_backoff_s = std::stod(require_value("--reconnect-min"));
+        } else if (arg == "--reconnect-max") {
+            reconnect_opts.max_backoff_s = std::stod(require_value("--reconnect-max"));
+        } else if (arg == "--rt-policy") {
+            rt_opts.policy = vrpn_common::parse_sched_policy(require_value("--rt-policy"));
+        } else if (arg == "--rt-priority") {
+            rt_opts.priority = std::stoi(require_value("--rt-priority"));
+        } else if (arg == "--rt-cpu-vrpn") {
+            rt_cpu_vrpn = std::stoi(require_value("--rt-cpu-vrpn"));
+        } else if (arg == "--rt-cpu-send") {
+            rt_cpu_send = std::stoi(require_value("--rt-cpu-send"));
+        } else if (arg == "--rt-mlock") {
+            rt_opts.lock_memory = true;
+        } else if (arg == "--rt-jitter-test") {
+            jitter_test_s = std::stod(require_value("--rt-jitter-test"));
+        } else if (arg == "--trace") {
+            trace_path = require_value("--trace");
+        } else if (arg == "--control") {
+            control_path = require_value("--control");
         } else if (arg == "--help" || arg == "-h") {
             print_usage(argv[0]);
             return 0;
@@ -114,14 +265,54 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (tracker_name.empty()) {
-        std::cerr << "--tracker is required\n";
+    if (rate_hz <= 0.0) {
+        rate_hz = 50.0;
+    }
+
+    if (jitter_test_s > 0.0) {
+        // Same period as the send loop, measured first as an ordinary thread and then with the profile.
+        std::cout << "[vrpn_receiver] default scheduling: "
+                  << vrpn_common::format_jitter(vrpn_common::measure_wakeup_jitter(1.0 / rate_hz, jitter_test_s))
+                  << "\n";
+        if (rt_opts.lock_memory) {
+            log_realtime("memory", vrpn_common::lock_process_memory());
+        }
+        log_realtime("send thread", vrpn_common::apply_thread_profile(rt_opts, rt_cpu_send));
+        std::cout << "[vrpn_receiver] real-time profile: "
+                  << vrpn_common::format_jitter(vrpn_common::measure_wakeup_jitter(1.0 / rate_hz, jitter_test_s))
+                  << "\n";
+        return 0;
+    }
+
+    if (!tracker_name.empty()) {
+        vehicle_specs.insert(vehicle_specs.begin(), receiver::VehicleSpec{tracker_name, link_opts.system_id, 1.0});
+    }
+    if (vehicle_specs.empty()) {
+        std::cerr << "--tracker or --vehicle is required\n";
         print_usage(argv[0]);
         return 1;
     }
-
-    if (rate_hz <= 0.0) {
-        rate_hz = 50.0;
+    for (size_t i = 0; i < vehicle_specs.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            // The FC and GCS tell vehicles apart by sysid alone; two trackers on one would interleave.
+            if (vehicle_specs[j].system_id == vehicle_specs[i].system_id) {
+                std::cerr << vehicle_specs[j].tracker << " and " << vehicle_specs[i].tracker << " both use sysid "
+                          << int(vehicle_specs[i].system_id) << "\n";
+                return 1;
+            }
+        }
+    }
+    if (!capture_path.empty() && vehicle_specs.size() > 1) {
+        std::cerr << "--capture records a single tracker; drop it or forward one vehicle\n";
+        return 1;
+    }
+    if (!sources.empty() && !shm_name.empty()) {
+        std::cerr << "--source and --shm are mutually exclusive\n";
+        return 1;
+    }
+    if (link_budget < 0.0) {
+        // 8N1 framing costs 10 bits per byte; keep 10 % of the line for anything else on the radio.
+        link_budget = link_opts.link_type == "serial" ? 0.9 * link_opts.baud_rate / 10.0 : 0.0;
     }
 
     auto normalize_host = [](std::string value) {
@@ -132,67 +323,499 @@ int main(int argc, char** argv) {
     };
 
     host = normalize_host(host);
+    if (sources.empty()) {
+        sources.push_back(host + ":" + std::to_string(port));
+    }
+    for (auto& source : sources) {
+        const auto colon = source.rfind(':');
+        if (colon == std::string::npos) {
+            std::cerr << "--source expects <host>:<port>, got '" << source << "'\n";
+            return 1;
+        }
+        source = normalize_host(source.substr(0, colon)) + source.substr(colon);
+    }
 
     try {
         using clock = std::chrono::steady_clock;
-        const auto send_period =
-            std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate_hz));
+
+        if (rt_opts.lock_memory) {
+            log_realtime("memory", vrpn_common::lock_process_memory());
+        }
+        if (!trace_path.empty()) {
+            if (vrpn_common::kTracingEnabled) {
+                vrpn_common::trace_install(trace_path);
+                std::cout << "[vrpn_receiver] tracing to " << trace_path << " (written at exit or on SIGUSR1)\n";
+            } else {
+                std::cerr << "[vrpn_receiver] --trace ignored: built without -DVRPN_BRIDGE_TRACING=ON\n";
+            }
+        }
 
         receiver::MavlinkSender sender(link_opts);
-        const std::string tracker_address = tracker_name + "@" + host + ":" + std::to_string(port);
-        receiver::TrackerClient tracker(tracker_address);
+        std::unique_ptr<receiver::MavlinkRelay> relay;
+        if (!gcs_endpoints.empty()) {
+            relay = std::make_unique<receiver::MavlinkRelay>(sender, gcs_endpoints,
+                                                            static_cast<uint16_t>(gcs_bind_port));
+            std::cout << "[vrpn_receiver] relaying FC telemetry to " << gcs_endpoints.size()
+                      << " GCS endpoint(s), listening on UDP " << relay->local_port() << "\n";
+        }
+        std::unique_ptr<receiver::ControlSocket> control;
+        if (!control_path.empty()) {
+            control = std::make_unique<receiver::ControlSocket>(control_path);
+            std::cout << "[vrpn_receiver] control socket at " << control_path << "\n";
+        }
+        std::unique_ptr<receiver::CaptureWriter> capture;
+        if (!capture_path.empty()) {
+            capture = std::make_unique<receiver::CaptureWriter>(capture_path);
+        }
+
+        uint8_t probe[receiver::kMaxMavlinkFrameLength];
+        receiver::Pose probe_pose;
+        probe_pose.timestamp_sec = 1.0;
+        probe_pose.x = probe_pose.y = probe_pose.z = 1.0;
+        probe_pose.roll = probe_pose.pitch = probe_pose.yaw = 0.1;
+        receiver::LinkScheduler scheduler(
+            link_budget, receiver::encode_vision_position_estimate(probe_pose, 1, 1, probe));
+
+        // Shared memory is read in place on the send thread right before each send; VRPN needs its
+        // own thread to keep the connections serviced between sends.
+        const bool poll_inline = !shm_name.empty();
+
+        auto make_vehicle = [&](const receiver::VehicleSpec& spec) {
+            auto vehicle     = std::make_shared<Vehicle>();
+            vehicle->tracker = spec.tracker;
+            vehicle->added   = clock::now();
+            if (shm_name.empty() && sources.size() > 1) {
+                for (const auto& source : sources) {
+                    vehicle->source_addresses.push_back(spec.tracker + "@" + source);
+                }
+                vehicle->address = vehicle->source_addresses.front() + " (+" + std::to_string(sources.size() - 1) +
+                                   " redundant)";
+                vehicle->source_disconnects.assign(sources.size(), 0);
+                vehicle->source_waiting.assign(sources.size(), false);
+            } else if (shm_name.empty()) {
+                vehicle->address = spec.tracker + "@" + sources.front();
+            } else {
+                vehicle->address = spec.tracker + " in shared memory " + shm_name;
+            }
+            return vehicle;
+        };
+        // VRPN objects are not thread-safe, so a vehicle's source is opened, spun and closed on the
+        // thread that polls it.
+        auto open_source = [&](Vehicle& vehicle) {
+            if (!vehicle.source_addresses.empty()) {
+                std::vector<std::unique_ptr<receiver::PoseSource>> clients;
+                for (const auto& address : vehicle.source_addresses) {
+                    clients.push_back(std::make_unique<receiver::TrackerClient>(address, reconnect_opts));
+                }
+                auto redundant    = std::make_unique<receiver::RedundantPoseSource>(std::move(clients),
+                                                                                 primary_tolerance_ms / 1000.0);
+                vehicle.redundant = redundant.get();
+                vehicle.source    = std::move(redundant);
+            } else if (shm_name.empty()) {
+                vehicle.source = std::make_unique<receiver::TrackerClient>(vehicle.address, reconnect_opts);
+            } else {
+                vehicle.source = std::make_unique<receiver::ShmPoseSource>(shm_name, vehicle.tracker);
+            }
+        };
+        auto close_source = [](Vehicle& vehicle) {
+            vehicle.redundant = nullptr;
+            vehicle.source.reset();
+        };
+
+        // Slots are shared with the scheduler and the transform stage. Every tracker gets the same
+        // frame options, so a slot freed by `remove` is reused as is.
+        receiver::FrameTransformStage transform;
+        receiver::PoseBatch batch;
+        std::vector<std::shared_ptr<Vehicle>> vehicles;  // null where a vehicle was removed
+        std::vector<uint64_t> sent_at_status;
 
-        std::mutex pose_mutex;
-        std::optional<receiver::Pose> latest_pose;
+        // The send thread owns `vehicles`; the VRPN thread polls its own copy of the list and swaps
+        // it for the published one when it changes, closing sources that left it and opening new
+        // ones. Vehicles in both keep their source, connection and mailbox untouched.
+        std::mutex published_mutex;
+        std::vector<std::shared_ptr<Vehicle>> published;
+        std::atomic<bool> published_changed{false};
+        auto publish_vehicles = [&]() {
+            if (poll_inline) {
+                return;  // sources live on the send thread already
+            }
+            std::lock_guard<std::mutex> lock(published_mutex);
+            published.clear();
+            for (const auto& vehicle : vehicles) {
+                if (vehicle) {
+                    published.push_back(vehicle);
+                }
+            }
+            published_changed = true;
+        };
+        auto adopt_vehicles = [&](std::vector<std::shared_ptr<Vehicle>>& polled) {
+            std::vector<std::shared_ptr<Vehicle>> next;
+            {
+                std::lock_guard<std::mutex> lock(published_mutex);
+                next = published;
+            }
+            for (auto& vehicle : polled) {
+                if (std::find(next.begin(), next.end(), vehicle) == next.end()) {
+                    close_source(*vehicle);
+                }
+            }
+            for (auto& vehicle : next) {
+                if (!vehicle->source) {
+                    try {
+                        open_source(*vehicle);
+                    } catch (const std::exception& ex) {
+                        std::cerr << "[vrpn_receiver] cannot open " << vehicle->address << ": " << ex.what() << "\n";
+                    }
+                }
+            }
+            polled = std::move(next);
+        };
+
+        // The startup vehicles are opened here, so the capture is attached before anything arrives.
+        // Later ones are opened by the thread that polls them.
+        bool starting = true;
+        receiver::VehicleRoster::Hooks hooks;
+        hooks.added = [&](size_t slot, const receiver::VehicleSpec& spec) {
+            auto vehicle = make_vehicle(spec);
+            if (starting || poll_inline) {
+                open_source(*vehicle);  // throws here, before anything changed, if it is not published
+            }
+            if (starting) {
+                vehicle->source->set_capture(capture.get());
+            } else if (capture) {
+                std::cerr << "[vrpn_receiver] " << spec.tracker << " is not captured; --capture records "
+                          << "the startup vehicle only\n";
+            }
+            if (slot >= vehicles.size()) {
+                vehicles.resize(slot + 1);
+                sent_at_status.resize(slot + 1);
+                while (transform.size() <= slot) {
+                    transform.add_tracker(frame_opts);
+                }
+                batch.resize(transform.size());
+            }
+            vehicles[slot]       = std::move(vehicle);
+            sent_at_status[slot] = 0;
+            publish_vehicles();
+        };
+        hooks.removed = [&](size_t slot) {
+            vehicles[slot].reset();
+            publish_vehicles();
+        };
+        hooks.describe = [&](size_t slot) {
+            Vehicle& vehicle = *vehicles[slot];
+            receiver::TrackerStats stats;
+            {
+                std::lock_guard<std::mutex> lock(vehicle.stats_mutex);
+                stats = vehicle.stats;
+            }
+            std::ostringstream out;
+            out << " stale=" << (vehicle.stale ? "yes" : "no") << " poses=" << stats.poses
+                << " disconnects=" << stats.disconnects << " source=" << vehicle.address;
+            return out.str();
+        };
+        hooks.link_summary = [&]() {
+            const auto& link = sender.link_stats();
+            std::ostringstream out;
+            out << "link frames_sent=" << link.frames_sent << " frames_dropped=" << link.frames_dropped
+                << " bytes=" << link.bytes_written << "\n";
+            return out.str();
+        };
+        receiver::VehicleRoster roster(scheduler, rate_hz, std::move(hooks));
+        for (const auto& spec : vehicle_specs) {
+            roster.add(spec, rate_hz);
+        }
+        starting = false;
+
+        if (scheduler.limited()) {
+            std::cout.setf(std::ios::fixed);
+            std::cout.precision(1);
+            std::cout << "[vrpn_receiver] link budget " << scheduler.link_bytes_per_s() << " B/s (~"
+                      << static_cast<int>(scheduler.capacity_hz()) << " frames/s): " << roster.allocation_summary()
+                      << "\n";
+        }
+
+        const auto stale_after =
+            std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(stale_timeout_s));
         std::atomic<bool> vrpn_running{true};
 
-        std::thread vrpn_thread([&]() {
-            while (vrpn_running && !g_should_exit) {
-                if (!tracker.spin_once()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-                    continue;
+        auto poll_source = [&](Vehicle& vehicle) {
+            // Backoff is handled inside spin_once, so callers keep their cadence throughout.
+            auto& source = *vehicle.source;
+            if (source.spin_once()) {
+                if (auto pose = source.latest_pose()) {
+                    vehicle.mailbox.publish(*pose, source.last_pose_time());
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(vehicle.stats_mutex);
+                vehicle.stats = source.stats();
+            }
+
+            if (vehicle.redundant) {
+                // One server dropping is not an outage; report each source and every failover.
+                auto& redundant = *vehicle.redundant;
+                for (size_t i = 0; i < redundant.size(); ++i) {
+                    const auto& stats = redundant.source(i).stats();
+                    if (stats.disconnects != vehicle.source_disconnects[i]) {
+                        vehicle.source_disconnects[i] = stats.disconnects;
+                        vehicle.source_waiting[i]     = true;
+                        std::cout << "[vrpn_receiver] connection to " << vehicle.source_addresses[i]
+                                  << " lost, reconnecting\n";
+                    } else if (vehicle.source_waiting[i] && redundant.source_live(i)) {
+                        vehicle.source_waiting[i] = false;
+                        std::cout << "[vrpn_receiver] " << vehicle.source_addresses[i] << " reconnected after "
+                                  << stats.last_disconnect_s << "s\n";
+                    }
                 }
-                if (auto pose = tracker.latest_pose()) {
-                    std::lock_guard<std::mutex> lock(pose_mutex);
-                    latest_pose = *pose;
+                if (redundant.switches() != vehicle.reported_switches) {
+                    vehicle.reported_switches = redundant.switches();
+                    std::cout << "[vrpn_receiver] " << vehicle.tracker << " now forwarding from "
+                              << vehicle.source_addresses[redundant.active()] << "\n";
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                return;
+            }
+
+            const auto& stats = source.stats();
+            if (stats.disconnects != vehicle.reported_disconnects) {
+                vehicle.reported_disconnects = stats.disconnects;
+                vehicle.waiting_for_pose     = true;
+                std::cout << "[vrpn_receiver] connection to " << vehicle.address << " lost, reconnecting\n";
+            } else if (vehicle.waiting_for_pose && source.latest_pose()) {
+                vehicle.waiting_for_pose = false;
+                std::cout << "[vrpn_receiver] " << vehicle.tracker << " reconnected after "
+                          << stats.last_disconnect_s << "s (time-to-first-pose " << stats.last_first_pose_s
+                          << "s, attempts " << stats.reconnect_attempts << ")\n";
             }
-        });
+        };
+
+        std::thread vrpn_thread;
+        if (!poll_inline) {
+            vrpn_thread = std::thread([&]() {
+                log_realtime("vrpn thread", vrpn_common::apply_thread_profile(rt_opts, rt_cpu_vrpn));
+                vrpn_common::trace_thread_name("vrpn");
+                std::vector<std::shared_ptr<Vehicle>> polled;
+                while (vrpn_running && !g_should_exit) {
+                    if (published_changed.exchange(false)) {
+                        adopt_vehicles(polled);
+                    }
+                    for (auto& vehicle : polled) {
+                        if (vehicle->source) {
+                            poll_source(*vehicle);
+                        }
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            });
+        }
+
+        log_realtime("send thread", vrpn_common::apply_thread_profile(rt_opts, rt_cpu_send));
+        vrpn_common::trace_thread_name("send");
+
+        const auto start = clock::now();
+        const auto status_period =
+            std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(status_interval_s));
+        auto next_status = start + status_period;
+        bool capture_failure_reported = false;
+        bool relay_fc_lost_reported   = false;
+        bool relay_gcs_lost_reported  = false;
+        std::vector<size_t> ready;
+        std::vector<size_t> due;
 
-        auto next_send = clock::now();
         while (!g_should_exit) {
-            const auto now = clock::now();
-            if (now >= next_send) {
-                std::optional<receiver::Pose> pose_copy;
-                {
-                    std::lock_guard<std::mutex> lock(pose_mutex);
-                    pose_copy = latest_pose;
-                }
-                if (pose_copy) {
-                    sender.send_pose(*pose_copy);
-                    if (log_poses) {
-                        std::cout.setf(std::ios::fixed);
-                        std::cout.precision(3);
-                        std::cout << "[vrpn_receiver] t=" << pose_copy->timestamp_sec << " pos=("
-                                  << std::setw(7) << pose_copy->x << ", " << std::setw(7)
-                                  << pose_copy->y << ", " << std::setw(4) << pose_copy->z << ") rpy=("
-                                  << std::setw(6) << pose_copy->roll << ", " << std::setw(6)
-                                  << pose_copy->pitch << ", " << std::setw(7) << pose_copy->yaw
-                                  << ")\n";
+            {
+                // Covers the tick's work only; the sleep below shows up as the gap between ticks.
+                VRPN_TRACE_SCOPE("send_tick");
+                const auto now = clock::now();
+                scheduler.advance(now);
+
+                ready.clear();
+                for (size_t i = 0; i < vehicles.size(); ++i) {
+                    if (!vehicles[i]) {
+                        continue;
+                    }
+                    Vehicle& vehicle = *vehicles[i];
+                    // A stale vehicle has no send slots; it is polled every tick so it can come back.
+                    if (poll_inline && (scheduler.due(i) || vehicle.stale)) {
+                        poll_source(vehicle);
                     }
+                    receiver::Pose pose;
+                    clock::time_point pose_time;
+                    if (!vehicle.mailbox.read(pose, pose_time)) {
+                        continue;
+                    }
+                    // Never feed the FC a frozen pose: past the threshold, go silent until fresh data returns.
+                    const bool now_stale = stale_timeout_s > 0.0 && now - pose_time > stale_after;
+                    if (now_stale != vehicle.stale) {
+                        vehicle.stale = now_stale;
+                        // Its share goes to the vehicles that still have poses to send.
+                        scheduler.set_paused(i, now_stale);
+                        std::cout << "[vrpn_receiver] " << vehicle.tracker
+                                  << (vehicle.stale ? " pose stale, forwarding paused\n"
+                                                    : " fresh pose, forwarding resumed\n");
+                    }
+                    if (vehicle.stale) {
+                        ++vehicle.stale_ticks;
+                        continue;
+                    }
+                    if (scheduler.due(i)) {
+                        batch.set(i, pose);
+                        ready.push_back(i);
+                    }
+                }
+
+                // The link bucket may not fit every due vehicle; the one with the most banked slots,
+                // i.e. furthest behind its allocation, goes first.
+                std::sort(ready.begin(), ready.end(),
+                          [&](size_t a, size_t b) { return scheduler.credit(a) > scheduler.credit(b); });
+                due.clear();
+                for (size_t i : ready) {
+                    if (scheduler.acquire(i)) {
+                        due.push_back(i);
+                    }
+                }
+
+                if (!due.empty()) {
+                    // Only the due slots were refreshed; transforming the rest would transform their
+                    // last output a second time.
+                    transform.apply(batch, due);
+                    for (size_t i : due) {
+                        const receiver::Pose pose = batch.get(i);
+                        scheduler.commit(i, sender.send_pose(pose, roster.spec(i).system_id));
+                        if (log_poses) {
+                            std::cout.setf(std::ios::fixed);
+                            std::cout.precision(3);
+                            std::cout << "[vrpn_receiver] " << vehicles[i]->tracker << " t=" << pose.timestamp_sec
+                                      << " pos=(" << std::setw(7) << pose.x << ", " << std::setw(7) << pose.y << ", "
+                                      << std::setw(4) << pose.z << ") rpy=(" << std::setw(6) << pose.roll << ", "
+                                      << std::setw(6) << pose.pitch << ", " << std::setw(7) << pose.yaw << ")\n";
+                        }
+                    }
+                }
+
+                if (status_interval_s > 0.0 && now >= next_status) {
+                    next_status += status_period;
+                    std::cout.setf(std::ios::fixed);
+                    std::cout.precision(1);
+                    std::cout << "[vrpn_receiver] effective rate Hz:";
+                    for (size_t i = 0; i < vehicles.size(); ++i) {
+                        if (!vehicles[i]) {
+                            continue;
+                        }
+                        const auto& share = scheduler.vehicle(i);
+                        std::cout << " " << vehicles[i]->tracker << "="
+                                  << (share.sent - sent_at_status[i]) / status_interval_s << "/"
+                                  << share.allocated_hz;
+                        sent_at_status[i] = share.sent;
+                    }
+                    std::cout << "\n";
+                }
+
+                // The writer disables itself on the VRPN thread; forwarding carries on without it.
+                if (capture && !capture_failure_reported && capture->failed()) {
+                    capture_failure_reported = true;
+                    std::cerr << "[vrpn_receiver] capture " << capture->error() << "; capture disabled\n";
                 }
-                do {
-                    next_send += send_period;
-                } while (now >= next_send);
+
+                // Finish a frame the serial port only partly accepted without waiting for the next tick.
+                sender.flush_pending();
+            }
+            if (control) {
+                // Between ticks, so a change takes effect from the next one.
+                VRPN_TRACE_SCOPE("control");
+                control->poll([&](const std::string& line) {
+                    const std::string reply = roster.handle(line);
+                    if (reply.compare(0, 3, "ok ") == 0) {
+                        std::cout << "[vrpn_receiver] control: " << line << " -> " << reply;
+                    }
+                    return reply;
+                });
+            }
+            // With a relay the wait between ticks is spent in poll(), so telemetry and GCS commands
+            // cross as they arrive instead of once per tick.
+            if (relay) {
+                relay->service_until(clock::now() + std::chrono::milliseconds(2));
+                if (relay->fc_lost() && !relay_fc_lost_reported) {
+                    relay_fc_lost_reported = true;
+                    std::cerr << "[vrpn_receiver] relay: FC link hung up or failed; no longer reading telemetry\n";
+                }
+                if (relay->gcs_lost() && !relay_gcs_lost_reported) {
+                    relay_gcs_lost_reported = true;
+                    std::cerr << "[vrpn_receiver] relay: GCS socket failed; no longer relaying GCS traffic\n";
+                }
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(2));
         }
 
         vrpn_running = false;
         if (vrpn_thread.joinable()) {
             vrpn_thread.join();
         }
+        const auto end = clock::now();
+        std::cout.setf(std::ios::fixed);
+        std::cout.precision(3);
+        for (size_t i = 0; i < vehicles.size(); ++i) {
+            if (!vehicles[i]) {
+                continue;
+            }
+            const auto& vehicle  = *vehicles[i];
+            const auto stats     = vehicle.source ? vehicle.source->stats() : receiver::TrackerStats{};
+            const auto& share    = scheduler.vehicle(i);
+            const double elapsed = std::max(std::chrono::duration<double>(end - vehicle.added).count(), 1e-3);
+            std::cout << "[vrpn_receiver] " << vehicle.tracker << " sysid=" << int(roster.spec(i).system_id)
+                      << " poses=" << stats.poses << " disconnects=" << stats.disconnects
+                      << " reconnect_attempts=" << stats.reconnect_attempts
+                      << " disconnected_total=" << stats.total_disconnect_s << "s"
+                      << " first_pose_max=" << stats.max_first_pose_s << "s"
+                      << " stale_ticks=" << vehicle.stale_ticks << " sent=" << share.sent
+                      << " effective=" << share.sent / elapsed << "/" << share.allocated_hz << " Hz"
+                      << " deferred=" << share.deferred << " dropped=" << share.dropped << "\n";
+            if (vehicle.redundant) {
+                const auto& redundant = *vehicle.redundant;
+                for (size_t s = 0; s < redundant.size(); ++s) {
+                    const auto& source = redundant.source_stats(s);
+                    const double lag_ms =
+                        source.lag_samples ? 1000.0 * source.lag_sum_s / double(source.lag_samples) : 0.0;
+                    const double latency_ms =
+                        source.received ? 1000.0 * source.latency_sum_s / double(source.received) : 0.0;
+                    std::cout << "[vrpn_receiver]   " << vehicle.source_addresses[s] << (s == 0 ? " (primary)" : "")
+                              << " received=" << source.received << " selected=" << source.selected
+                              << " late=" << source.late << " missed=" << source.missed
+                              << " loss=" << 100.0 * source.loss() << "%"
+                              << " lag_mean=" << lag_ms << "ms lag_max=" << 1000.0 * source.lag_max_s << "ms"
+                              << " latency_mean=" << latency_ms << "ms latency_max="
+                              << 1000.0 * source.latency_max_s << "ms"
+                              << " disconnects=" << redundant.source(s).stats().disconnects << "\n";
+                }
+                std::cout << "[vrpn_receiver]   source switches=" << redundant.switches() << "\n";
+            }
+        }
+        const auto& link = sender.link_stats();
+        std::cout << "[vrpn_receiver] link frames_sent=" << link.frames_sent << " frames_dropped=" << link.frames_dropped
+                  << " partial_writes=" << link.partial_writes << " bytes=" << link.bytes_written << "\n";
+        for (size_t i = 0; i < sender.mirror_count(); ++i) {
+            const auto& mirror = sender.mirror_stats(i);
+            std::cout << "[vrpn_receiver] mirror " << sender.mirror_name(i) << " frames_sent=" << mirror.frames_sent
+                      << " frames_dropped=" << mirror.frames_dropped << " partial_writes=" << mirror.partial_writes
+                      << " bytes=" << mirror.bytes_written << "\n";
+        }
+        if (relay) {
+            const auto& relayed = relay->stats();
+            std::cout << "[vrpn_receiver] relay fc_to_gcs=" << relayed.fc_frames << " (" << relayed.fc_bytes
+                      << " B, crc_errors=" << relayed.fc_crc_errors << ", unknown=" << relayed.fc_unknown
+                      << ", send_errors=" << relayed.send_errors << ") gcs_to_fc=" << relayed.gcs_frames
+                      << " (crc_errors=" << relayed.gcs_crc_errors << ", unknown=" << relayed.gcs_unknown
+                      << ", rejected=" << relayed.gcs_rejected << ")\n";
+        }
+        if (capture) {
+            capture->flush();
+            std::cout << "[vrpn_receiver] captured " << capture->records() << " reports to " << capture_path;
+            if (capture->failed()) {
+                std::cout << " (then " << capture->error() << ", " << capture->dropped() << " reports not recorded)";
+            }
+            std::cout << "\n";
+        }
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << "\n";
         return 1;
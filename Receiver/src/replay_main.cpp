@@ -0,0 +1,325 @@
+#include "receiver/FrameTransform.h"
+#include "receiver/MavlinkSender.h"
+#include "receiver/PoseCapture.h"
+#include "receiver/TrackerClient.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+volatile std::sig_atomic_t g_should_exit = 0;
+
+void handle_signal(int) {
+    g_should_exit = 1;
+}
+
+const char* program_name(const char* exe) {
+    if (exe == nullptr) {
+        return "vrpn_replay";
+    }
+    const char* slash = std::strrchr(exe, '/');
+    const char* backslash = std::strrchr(exe, '\\');
+    const char* base = exe;
+    if (slash && (!backslash || slash > backslash)) {
+        base = slash + 1;
+    } else if (backslash) {
+        base = backslash + 1;
+    }
+    return base;
+}
+
+void print_usage(const char* exe) {
+    const char* prog = program_name(exe);
+    std::cout << "Usage: " << prog << " --input <capture> [options]\n";
+    std::cout << "Options:\n"
+              << "  --input <file>          Capture written by vrpn_receiver --capture\n"
+              << "  --timing <fast|recorded> Replay as fast as possible or at recorded timing (default fast)\n"
+              << "  --speed <x>             Time scale for --timing recorded (default 1.0)\n"
+              << "  --loops <N>             Replay the capture N times (default 1)\n"
+              << "  --link <serial|udp>     Output link type (default udp)\n"
+              << "  --device <path>         Serial device (default /dev/ttyUSB0)\n"
+              << "  --baud <rate>           Serial baud rate (default 921600)\n"
+              << "  --udp-target host:port  UDP target (default: in-process sink on 127.0.0.1)\n"
+              << "  --sysid <id>            MAVLink system id (default 1)\n"
+              << "  --compid <id>           MAVLink component id (default 1)\n"
+              << "  --frame <none|enu|yup>  Mocap frame converted to NED/FRD (default none)\n"
+              << "  --yaw-offset <deg>      Heading of mocap north relative to NED north (default 0)\n"
+              << "  --origin-offset x,y,z   NED offset added after rotation, metres (default 0,0,0)\n"
+              << "  --body-offset x,y,z     FRD lever arm from rigid-body pivot to vehicle origin (default 0,0,0)\n"
+              << "\nExamples:\n"
+              << "  " << prog << " --input field.cap\n"
+              << "  " << prog << " --input field.cap --timing recorded --udp-target 127.0.0.1:14550\n";
+}
+
+// Binds 127.0.0.1:<ephemeral> and drains it on a thread so replay has a real socket to send to.
+class LocalSink {
+public:
+    LocalSink() {
+        socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (socket_ < 0) {
+            throw std::runtime_error("Failed to create sink socket");
+        }
+        int rcvbuf = 4 * 1024 * 1024;
+        ::setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        timeval timeout{0, 100000};
+        ::setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+        socklen_t len        = sizeof(addr);
+        if (::bind(socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::getsockname(socket_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            ::close(socket_);
+            throw std::runtime_error("Failed to bind sink socket");
+        }
+        port_   = ntohs(addr.sin_port);
+        thread_ = std::thread([this]() { drain(); });
+    }
+
+    ~LocalSink() {
+        stop();
+        ::close(socket_);
+    }
+
+    void stop() {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::string target() const { return "127.0.0.1:" + std::to_string(port_); }
+    uint64_t datagrams() const { return datagrams_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    void drain() {
+        uint8_t buffer[2048];
+        while (running_) {
+            const ssize_t n = ::recv(socket_, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                datagrams_ += 1;
+                bytes_ += static_cast<uint64_t>(n);
+            }
+        }
+        // Pick up whatever is still queued after the last send.
+        ssize_t n = 0;
+        while ((n = ::recv(socket_, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            datagrams_ += 1;
+            bytes_ += static_cast<uint64_t>(n);
+        }
+    }
+
+    int socket_    = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_{true};
+    std::atomic<uint64_t> datagrams_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::thread thread_;
+};
+
+double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    std::string input_path;
+    bool recorded_timing = false;
+    double speed         = 1.0;
+    int loops            = 1;
+    bool have_target     = false;
+    receiver::MavlinkOptions link_opts;
+    link_opts.link_type = "udp";
+    receiver::FrameTransformOptions frame_opts;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto require_value = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << name << " requires a value\n";
+                print_usage(argv[0]);
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--input") {
+            input_path = require_value("--input");
+        } else if (arg == "--timing") {
+            const std::string timing = require_value("--timing");
+            if (timing != "fast" && timing != "recorded") {
+                std::cerr << "Unknown timing '" << timing << "'. Use 'fast' or 'recorded'.\n";
+                return 1;
+            }
+            recorded_timing = timing == "recorded";
+        } else if (arg == "--speed") {
+            speed = std::stod(require_value("--speed"));
+        } else if (arg == "--loops") {
+            loops = std::stoi(require_value("--loops"));
+        } else if (arg == "--link") {
+            link_opts.link_type = require_value("--link");
+        } else if (arg == "--device") {
+            link_opts.serial_device = require_value("--device");
+        } else if (arg == "--baud") {
+            link_opts.baud_rate = std::stoi(require_value("--baud"));
+        } else if (arg == "--udp-target") {
+            link_opts.udp_target = require_value("--udp-target");
+            have_target          = true;
+        } else if (arg == "--sysid") {
+            link_opts.system_id = static_cast<uint8_t>(std::stoi(require_value("--sysid")));
+        } else if (arg == "--compid") {
+            link_opts.component_id = static_cast<uint8_t>(std::stoi(require_value("--compid")));
+        } else if (arg == "--frame") {
+            frame_opts.frame = receiver::parse_mocap_frame(require_value("--frame"));
+        } else if (arg == "--yaw-offset") {
+            frame_opts.yaw_offset_rad = std::stod(require_value("--yaw-offset")) * M_PI / 180.0;
+        } else if (arg == "--origin-offset") {
+            frame_opts.origin_offset = receiver::parse_vector3(require_value("--origin-offset"));
+        } else if (arg == "--body-offset") {
+            frame_opts.body_offset = receiver::parse_vector3(require_value("--body-offset"));
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (input_path.empty()) {
+        std::cerr << "--input is required\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (speed <= 0.0) {
+        speed = 1.0;
+    }
+    if (loops < 1) {
+        loops = 1;
+    }
+
+    try {
+        using clock = std::chrono::steady_clock;
+
+        receiver::CaptureReader capture(input_path);
+        if (capture.size() == 0) {
+            std::cerr << "Capture " << input_path << " holds no records\n";
+            return 1;
+        }
+
+        std::unique_ptr<LocalSink> sink;
+        if (link_opts.link_type == "udp" && !have_target) {
+            sink                 = std::make_unique<LocalSink>();
+            link_opts.udp_target = sink->target();
+        }
+
+        receiver::MavlinkSender sender(link_opts);
+        receiver::FrameTransformStage transform;
+        transform.add_tracker(frame_opts);
+        receiver::PoseBatch batch;
+        batch.resize(transform.size());
+
+        std::vector<double> pipeline_ns;
+        std::vector<double> lateness_us;
+        pipeline_ns.reserve(capture.size() * static_cast<size_t>(loops));
+        if (recorded_timing) {
+            lateness_us.reserve(pipeline_ns.capacity());
+        }
+
+        const int64_t first_arrival_us = capture[0].arrival_us;
+        const auto replay_start         = clock::now();
+        uint64_t sent                   = 0;
+
+        for (int loop = 0; loop < loops && !g_should_exit; ++loop) {
+            const auto loop_start = clock::now();
+            for (size_t i = 0; i < capture.size() && !g_should_exit; ++i) {
+                const receiver::CaptureRecord& record = capture[i];
+                if (recorded_timing) {
+                    const auto offset = std::chrono::duration<double, std::micro>(
+                        static_cast<double>(record.arrival_us - first_arrival_us) / speed);
+                    const auto due = loop_start + std::chrono::duration_cast<clock::duration>(offset);
+                    std::this_thread::sleep_until(due);
+                    lateness_us.push_back(std::chrono::duration<double, std::micro>(clock::now() - due).count());
+                }
+
+                const auto begin = clock::now();
+                batch.set(0, receiver::from_tracker_cb(receiver::to_tracker_cb(record)));
+                transform.apply(batch);
+                sender.send_pose(batch.get(0));
+                pipeline_ns.push_back(std::chrono::duration<double, std::nano>(clock::now() - begin).count());
+                ++sent;
+            }
+        }
+
+        // Let a frame the serial port only partly accepted finish before reading the counters.
+        for (int i = 0; i < 100 && !sender.flush_pending(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const double elapsed = std::chrono::duration<double>(clock::now() - replay_start).count();
+        if (sink) {
+            // Give the kernel a moment to hand over the tail before reading the counters.
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            sink->stop();
+        }
+
+        double mean_ns = 0.0;
+        for (double value : pipeline_ns) {
+            mean_ns += value;
+        }
+        mean_ns /= static_cast<double>(std::max<size_t>(pipeline_ns.size(), 1));
+
+        std::cout.setf(std::ios::fixed);
+        std::cout.precision(1);
+        std::cout << "[vrpn_replay] records=" << capture.size() << " loops=" << loops << " sent=" << sent
+                  << " elapsed=" << elapsed << "s throughput=" << (elapsed > 0.0 ? sent / elapsed : 0.0)
+                  << " poses/s\n";
+        std::cout << "[vrpn_replay] pipeline ns: mean=" << mean_ns << " p50=" << percentile(pipeline_ns, 0.5)
+                  << " p99=" << percentile(pipeline_ns, 0.99) << " max=" << percentile(pipeline_ns, 1.0)
+                  << "\n";
+        if (recorded_timing) {
+            std::cout << "[vrpn_replay] schedule lateness us: p50=" << percentile(lateness_us, 0.5)
+                      << " p99=" << percentile(lateness_us, 0.99) << " max=" << percentile(lateness_us, 1.0)
+                      << "\n";
+        }
+        const auto& link = sender.link_stats();
+        std::cout << "[vrpn_replay] link frames_sent=" << link.frames_sent << " frames_dropped=" << link.frames_dropped
+                  << " partial_writes=" << link.partial_writes << " bytes=" << link.bytes_written << "\n";
+        if (sink) {
+            std::cout << "[vrpn_replay] sink received " << sink->datagrams() << "/" << sent << " datagrams ("
+                      << sink->bytes() << " bytes)\n";
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vrpn_sim {
+
+struct ClientReport {
+    std::string tracker;
+    uint64_t reports = 0;
+    double rate_hz   = 0.0;  // reports over the whole time the clients were subscribed
+    double max_gap_s = 0.0;  // longest wait between reports, or from the last one to the end of the test
+};
+
+// N independent VRPN client connections to the local server, spun from one background thread,
+// standing in for a room full of ground tools and receivers. Each client opens its own
+// connection (forced, not shared by name) and subscribes to one tracker, round-robin.
+class LoadTestClients {
+public:
+    LoadTestClients(const std::string& server, const std::vector<std::string>& trackers, int client_count);
+    ~LoadTestClients();
+
+    LoadTestClients(const LoadTestClients&)            = delete;
+    LoadTestClients& operator=(const LoadTestClients&) = delete;
+
+    void start();
+    // Joins the client thread; results() is valid afterwards.
+    void stop();
+    std::vector<ClientReport> results() const;
+
+private:
+    struct Client;
+
+    void run();
+
+    std::string server_;
+    std::vector<std::string> trackers_;
+    int client_count_ = 0;
+    std::vector<std::unique_ptr<Client>> clients_;
+    std::atomic<bool> running_{false};
+    // Set on the client thread; read by results() after stop() joined it.
+    std::chrono::steady_clock::time_point subscribed_{};
+    std::chrono::steady_clock::time_point stopped_{};
+    std::thread thread_;
+};
+
+}  // namespace vrpn_sim
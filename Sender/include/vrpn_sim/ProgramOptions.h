@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "vrpn_common/Realtime.h"
+
 namespace vrpn_sim {
 
 struct ProgramOptions {
@@ -15,6 +17,13 @@ struct ProgramOptions {
     bool status_single_line  = false;
     bool status_include_pose = true;
     int status_pose_tracker  = 0;
+    vrpn_common::RealtimeOptions realtime;
+    int realtime_cpu         = -1;
+    double jitter_test_s     = 0.0;
+    std::string shm_name;  // also publish into this shared-memory pose table when set
+    std::string trace_path;  // Chrome trace JSON, written at exit and on SIGUSR1 (tracing builds only)
+    int load_test_clients       = 0;  // > 0: connect this many in-process clients, report, then exit
+    double load_test_duration_s = 10.0;
 };
 
 ProgramOptions parse_args(int argc, char** argv);
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace vrpn_sim {
+
+struct TrackerSample {
+    double pos[3]  = {0.0, 0.0, 0.0};
+    double quat[4] = {0.0, 0.0, 0.0, 1.0};
+};
+
+// Deterministic circular motion plus yaw for tracker `index` at `sim_time` seconds. Each tracker
+// gets its own radius, angular rate, phase and altitude so downstream consumers can tell them apart.
+void compute_tracker_sample(int index, double sim_time, TrackerSample& sample);
+
+// Fills samples[0..count) for one publish tick.
+void compute_tracker_samples(double sim_time, TrackerSample* samples, int count);
+
+}  // namespace vrpn_sim
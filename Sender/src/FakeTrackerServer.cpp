@@ -1,6 +1,11 @@
 #include "vrpn_sim/FakeTrackerServer.h"
 
+#include "vrpn_sim/LoadTestClients.h"
 #include "vrpn_sim/ProgramOptions.h"
+#include "vrpn_sim/Trajectory.h"
+#include "vrpn_common/Realtime.h"
+#include "vrpn_common/SharedPoseTable.h"
+#include "vrpn_common/Trace.h"
 
 #include <vrpn_Connection.h>
 #include <vrpn_Tracker.h>
@@ -44,6 +49,19 @@ inline double unix_time_seconds() {
     return duration_cast<duration<double>>(duration_since_epoch).count();
 }
 
+// While waiting for the next tick the connection is serviced this often, so handshakes, pings and
+// client reads are spread over the idle time instead of piling onto the publish tick.
+constexpr std::chrono::milliseconds kServiceSlice{1};
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
 }  // namespace
 
 namespace vrpn_sim {
@@ -78,13 +96,21 @@ struct FakeTrackerServer::Impl {
     }
 
     int run() {
+        if (opts_.jitter_test_s > 0.0) {
+            return run_jitter_test();
+        }
+        apply_realtime_profile();
+        install_trace();
         try {
+            create_shared_table();
             while (!g_should_exit.load()) {
                 if (!create_connection()) {
                     return 1;
                 }
                 spawn_trackers();
+                start_load_test();
                 mainloop();
+                finish_load_test();
                 teardown_connection();
 
                 if (g_should_exit.load()) {
@@ -113,14 +139,75 @@ struct FakeTrackerServer::Impl {
         if (opts_.status_single_line) {
             std::printf("\n");
         }
+        if (ticks_ > 0 && !opts_.quiet) {
+            std::printf("Publish ticks: %llu, overruns %llu (%.2f%%), longest %.2f ms, latest start %.2f ms\n",
+                        static_cast<unsigned long long>(ticks_),
+                        static_cast<unsigned long long>(overruns_),
+                        100.0 * overruns_ / ticks_,
+                        tick_max_s_ * 1e3,
+                        late_max_s_ * 1e3);
+        }
         return 0;
     }
 
 private:
-    struct TrackerSample {
-        vrpn_float64 pos[3]  = {0.0, 0.0, 0.0};
-        vrpn_float64 quat[4] = {0.0, 0.0, 0.0, 1.0};
-    };
+    void apply_realtime_profile() {
+        if (opts_.realtime.lock_memory) {
+            report_realtime("memory", vrpn_common::lock_process_memory());
+        }
+        report_realtime("publish loop", vrpn_common::apply_thread_profile(opts_.realtime, opts_.realtime_cpu));
+    }
+
+    void report_realtime(const char* what, const vrpn_common::RealtimeReport& report) const {
+        if (!report.message.empty()) {
+            std::fprintf(stderr, "Real-time %s: %s\n", what, report.message.c_str());
+        }
+    }
+
+    void install_trace() {
+        if (opts_.trace_path.empty()) {
+            return;
+        }
+        if (!vrpn_common::kTracingEnabled) {
+            std::fprintf(stderr, "--trace ignored: built without -DVRPN_BRIDGE_TRACING=ON\n");
+            return;
+        }
+        vrpn_common::trace_thread_name("publish");
+        vrpn_common::trace_install(opts_.trace_path);
+        log_info("Tracing to %s (written at exit or on SIGUSR1)", opts_.trace_path.c_str());
+    }
+
+    int run_jitter_test() {
+        // Same period as the publish loop, measured first as an ordinary thread and then with the profile.
+        const double dt = 1.0 / opts_.publish_rate_hz;
+        std::printf("default scheduling: %s\n",
+                    vrpn_common::format_jitter(vrpn_common::measure_wakeup_jitter(dt, opts_.jitter_test_s)).c_str());
+        apply_realtime_profile();
+        std::printf("real-time profile:  %s\n",
+                    vrpn_common::format_jitter(vrpn_common::measure_wakeup_jitter(dt, opts_.jitter_test_s)).c_str());
+        return 0;
+    }
+
+    // Created once per run so receivers keep their mapping across --auto-restart cycles.
+    void create_shared_table() {
+        if (opts_.shm_name.empty()) {
+            return;
+        }
+        std::vector<std::string> names;
+        for (int i = 0; i < opts_.tracker_count; ++i) {
+            names.push_back(tracker_name(i));
+        }
+        shm_ = std::make_unique<vrpn_common::SharedPoseWriter>(opts_.shm_name, names);
+        log_info("Publishing %d trackers to shared memory %s",
+                 opts_.tracker_count,
+                 vrpn_common::shared_pose_segment_name(opts_.shm_name).c_str());
+    }
+
+    static std::string tracker_name(int index) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "uav%d", index);
+        return name;
+    }
 
     void normalize_bind_address() {
         if (opts_.bind_address.empty()) {
@@ -171,21 +258,95 @@ private:
         return true;
     }
 
+    void start_load_test() {
+        if (opts_.load_test_clients <= 0) {
+            return;
+        }
+        const auto colon = opts_.bind_address.rfind(':');
+        const std::string server = "127.0.0.1" + opts_.bind_address.substr(colon == std::string::npos ? 0 : colon);
+        std::vector<std::string> names;
+        for (int i = 0; i < opts_.tracker_count; ++i) {
+            names.push_back(tracker_name(i));
+        }
+        load_test_ = std::make_unique<LoadTestClients>(server, names, opts_.load_test_clients);
+        load_test_->start();
+        load_test_end_ = std::chrono::steady_clock::now() +
+                         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double>(opts_.load_test_duration_s));
+        std::printf("Load test: %d clients on %d trackers for %.1fs at %.1f Hz\n",
+                    opts_.load_test_clients,
+                    opts_.tracker_count,
+                    opts_.load_test_duration_s,
+                    opts_.publish_rate_hz);
+    }
+
+    void finish_load_test() {
+        if (!load_test_) {
+            return;
+        }
+        load_test_->stop();
+        const auto results = load_test_->results();
+        load_test_.reset();
+
+        double min_rate = results.empty() ? 0.0 : results.front().rate_hz;
+        double max_rate = 0.0;
+        double sum_rate = 0.0;
+        double max_gap  = 0.0;
+        int slow        = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& client = results[i];
+            std::printf("  client %3zu %-8s reports %8llu  rate %7.2f Hz  longest gap %8.2f ms\n",
+                        i,
+                        client.tracker.c_str(),
+                        static_cast<unsigned long long>(client.reports),
+                        client.rate_hz,
+                        client.max_gap_s * 1e3);
+            min_rate = std::min(min_rate, client.rate_hz);
+            max_rate = std::max(max_rate, client.rate_hz);
+            max_gap  = std::max(max_gap, client.max_gap_s);
+            sum_rate += client.rate_hz;
+            if (client.rate_hz < 0.9 * opts_.publish_rate_hz) {
+                ++slow;
+            }
+        }
+        std::printf("Load test delivery: min %.2f / mean %.2f / max %.2f Hz, %d of %zu clients below 90%% of %.1f Hz, "
+                    "longest gap %.2f ms\n",
+                    min_rate,
+                    results.empty() ? 0.0 : sum_rate / results.size(),
+                    max_rate,
+                    slow,
+                    results.size(),
+                    opts_.publish_rate_hz,
+                    max_gap * 1e3);
+        std::printf("Load test ticks: %llu, overruns %llu, p99 %.3f ms, longest %.3f ms\n",
+                    static_cast<unsigned long long>(ticks_),
+                    static_cast<unsigned long long>(overruns_),
+                    percentile(load_test_ticks_s_, 0.99) * 1e3,
+                    tick_max_s_ * 1e3);
+        std::printf("Load test tick start lateness: p99 %.3f ms, max %.3f ms\n",
+                    percentile(load_test_late_s_, 0.99) * 1e3,
+                    late_max_s_ * 1e3);
+        g_should_exit.store(true);
+    }
+
     void spawn_trackers() {
         trackers_.clear();
         trackers_.reserve(opts_.tracker_count);
         for (int i = 0; i < opts_.tracker_count; ++i) {
-            char tracker_name[32];
-            std::snprintf(tracker_name, sizeof(tracker_name), "uav%d", i);
-            trackers_.emplace_back(std::make_unique<vrpn_Tracker_Server>(tracker_name, connection_, 1));
-            log_info("  spawned tracker %s", tracker_name);
+            const std::string name = tracker_name(i);
+            trackers_.emplace_back(std::make_unique<vrpn_Tracker_Server>(name.c_str(), connection_, 1));
+            log_info("  spawned tracker %s", name.c_str());
         }
     }
 
     void mainloop() {
+        using clock = std::chrono::steady_clock;
         const double dt = 1.0 / opts_.publish_rate_hz;
+        const auto period =
+            std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
         double last_status_time = -opts_.status_interval_s;
         connection_failed_     = false;
+        auto deadline          = clock::now();
 
         while (!g_should_exit.load()) {
             if (!connection_->doing_okay()) {
@@ -194,11 +355,32 @@ private:
                 break;
             }
 
+            // The tick is publish + one mainloop that flushes the reports to every client. Its cost
+            // grows with the number of clients, so it is measured against the period.
+            const auto tick_start = clock::now();
             timeval ts = now_timeval();
             publish_trackers(ts);
-            connection_->mainloop();
-            std::this_thread::sleep_for(std::chrono::duration<double>(dt));
-            sim_time_ += dt;
+            {
+                VRPN_TRACE_SCOPE("connection_mainloop");
+                connection_->mainloop();
+            }
+            const auto tick_end = clock::now();
+            // A late wake-up delays the tick without costing work, so it is tracked apart from it.
+            const double late_s = std::max(std::chrono::duration<double>(tick_start - deadline).count(), 0.0);
+            deadline += period;
+            int slots = 1;
+            record_tick(std::chrono::duration<double>(tick_end - tick_start).count(), late_s, tick_end > deadline);
+            while (tick_end > deadline) {
+                deadline += period;  // skip the missed slots rather than bursting to catch up
+                ++slots;
+            }
+            service_until(deadline);
+            // Simulated motion keeps pace with the slots the tick used up, skipped ones included.
+            sim_time_ += slots * dt;
+
+            if (load_test_ && clock::now() >= load_test_end_) {
+                break;
+            }
 
             if (opts_.status_interval_s > 0.0) {
                 if (sim_time_ - last_status_time >= opts_.status_interval_s) {
@@ -209,40 +391,55 @@ private:
         }
     }
 
+    // Absolute deadlines, so the rate does not drift by the tick's own cost.
+    void service_until(std::chrono::steady_clock::time_point deadline) {
+        for (;;) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                return;
+            }
+            std::this_thread::sleep_until(std::min(deadline, now + kServiceSlice));
+            if (std::chrono::steady_clock::now() < deadline) {
+                VRPN_TRACE_SCOPE("connection_service");
+                connection_->mainloop();
+            }
+        }
+    }
+
+    void record_tick(double work_s, double late_s, bool overrun) {
+        ++ticks_;
+        if (overrun) {
+            ++overruns_;
+        }
+        tick_max_s_ = std::max(tick_max_s_, work_s);
+        late_max_s_ = std::max(late_max_s_, late_s);
+        if (opts_.status_interval_s > 0.0) {
+            tick_window_s_.push_back(work_s);
+            late_window_s_.push_back(late_s);
+        }
+        if (load_test_) {
+            load_test_ticks_s_.push_back(work_s);
+            load_test_late_s_.push_back(late_s);
+        }
+    }
+
     void publish_trackers(const timeval& ts) {
+        VRPN_TRACE_SCOPE("publish_trackers");
+        compute_tracker_samples(sim_time_, tracker_samples_.data(), opts_.tracker_count);
         for (int i = 0; i < opts_.tracker_count; ++i) {
-            auto* tracker = trackers_[i].get();
-            const double radius = 2.0 + 0.1 * i;
-            const double omega  = 0.2 + 0.01 * i;
-            const double phase  = i * (M_PI / 16.0);
-            const double angle  = omega * sim_time_ + phase;
-
-            vrpn_float64 pos[3];
-            pos[0] = radius * std::cos(angle);
-            pos[1] = radius * std::sin(angle);
-            pos[2] = 1.0 + 0.05 * i;
-
-            const double yaw      = angle;
-            const double half_yaw = yaw * 0.5;
-            vrpn_float64 quat[4];
-            quat[0] = 0.0;
-            quat[1] = 0.0;
-            quat[2] = std::sin(half_yaw);
-            quat[3] = std::cos(half_yaw);
-
-            tracker->report_pose(0, ts, pos, quat);
-
-            tracker_samples_[i].pos[0]  = pos[0];
-            tracker_samples_[i].pos[1]  = pos[1];
-            tracker_samples_[i].pos[2]  = pos[2];
-            tracker_samples_[i].quat[0] = quat[0];
-            tracker_samples_[i].quat[1] = quat[1];
-            tracker_samples_[i].quat[2] = quat[2];
-            tracker_samples_[i].quat[3] = quat[3];
+            const auto& sample = tracker_samples_[i];
+            trackers_[i]->report_pose(0, ts, sample.pos, sample.quat);
+            if (shm_) {
+                shm_->publish(static_cast<size_t>(i), ts.tv_sec, ts.tv_usec, sample.pos, sample.quat);
+            }
         }
     }
 
     void write_status_line() {
+        const double tick_p99_ms = percentile(tick_window_s_, 0.99) * 1e3;
+        const double late_p99_ms = percentile(late_window_s_, 0.99) * 1e3;
+        tick_window_s_.clear();
+        late_window_s_.clear();
         if (opts_.quiet) {
             return;
         }
@@ -251,12 +448,15 @@ private:
             const int tracker_idx = std::clamp(opts_.status_pose_tracker, 0, opts_.tracker_count - 1);
             const auto& sample    = tracker_samples_[tracker_idx];
             print_status(
-                "[%.3f] Sim time %.2fs | trackers: %d | interval %.1fs | tracker%d pos=(%.2f, %.2f, %.2f) "
-                "quat=(%.3f, %.3f, %.3f, %.3f)",
+                "[%.3f] Sim time %.2fs | trackers: %d | interval %.1fs | tick p99 %.2fms, late p99 %.2fms, "
+                "overruns %llu | tracker%d pos=(%.2f, %.2f, %.2f) quat=(%.3f, %.3f, %.3f, %.3f)",
                 unix_ts,
                 sim_time_,
                 opts_.tracker_count,
                 opts_.status_interval_s,
+                tick_p99_ms,
+                late_p99_ms,
+                static_cast<unsigned long long>(overruns_),
                 tracker_idx,
                 sample.pos[0],
                 sample.pos[1],
@@ -267,16 +467,20 @@ private:
                 sample.quat[3]);
         } else {
             print_status(
-                "[%.3f] Sim time %.2fs | trackers: %d | interval %.1fs",
+                "[%.3f] Sim time %.2fs | trackers: %d | interval %.1fs | tick p99 %.2fms, late p99 %.2fms, "
+                "overruns %llu",
                 unix_ts,
                 sim_time_,
                 opts_.tracker_count,
-                opts_.status_interval_s);
+                opts_.status_interval_s,
+                tick_p99_ms,
+                late_p99_ms,
+                static_cast<unsigned long long>(overruns_));
         }
     }
 
     void print_status(const char* fmt, ...) const {
-        char buffer[256];
+        char buffer[320];
         va_list args;
         va_start(args, fmt);
         std::vsnprintf(buffer, sizeof(buffer), fmt, args);
@@ -318,7 +522,18 @@ private:
     vrpn_Connection* connection_ = nullptr;
     std::vector<std::unique_ptr<vrpn_Tracker_Server>> trackers_;
     std::vector<TrackerSample> tracker_samples_;
+    std::unique_ptr<vrpn_common::SharedPoseWriter> shm_;
     bool connection_failed_ = false;
+    uint64_t ticks_         = 0;
+    uint64_t overruns_      = 0;  // tick work ran past the next deadline
+    double tick_max_s_      = 0.0;
+    double late_max_s_      = 0.0;  // tick started this long after its deadline
+    std::vector<double> tick_window_s_;  // since the last status line
+    std::vector<double> late_window_s_;
+    std::unique_ptr<LoadTestClients> load_test_;
+    std::chrono::steady_clock::time_point load_test_end_{};
+    std::vector<double> load_test_ticks_s_;
+    std::vector<double> load_test_late_s_;
 };
 
 FakeTrackerServer::FakeTrackerServer(ProgramOptions options)
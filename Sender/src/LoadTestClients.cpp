@@ -0,0 +1,114 @@
+#include "vrpn_sim/LoadTestClients.h"
+
+#include <vrpn_Connection.h>
+#include <vrpn_Tracker.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace vrpn_sim {
+
+struct LoadTestClients::Client {
+    using clock = std::chrono::steady_clock;
+
+    std::string tracker;
+    vrpn_Connection* connection = nullptr;
+    vrpn_Tracker_Remote* remote = nullptr;
+    uint64_t reports            = 0;
+    clock::time_point last_report{};
+    double max_gap_s = 0.0;
+
+    static void VRPN_CALLBACK handle_tracker(void* userdata, const vrpn_TRACKERCB) {
+        auto* self     = static_cast<Client*>(userdata);
+        const auto now = clock::now();
+        if (self->reports++ > 0) {
+            self->max_gap_s = std::max(self->max_gap_s, std::chrono::duration<double>(now - self->last_report).count());
+        }
+        self->last_report = now;
+    }
+};
+
+LoadTestClients::LoadTestClients(const std::string& server, const std::vector<std::string>& trackers,
+                                 int client_count)
+    : server_(server), trackers_(trackers), client_count_(client_count) {}
+
+LoadTestClients::~LoadTestClients() {
+    stop();
+}
+
+void LoadTestClients::start() {
+    running_ = true;
+    thread_  = std::thread([this]() { run(); });
+}
+
+void LoadTestClients::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::vector<ClientReport> LoadTestClients::results() const {
+    std::vector<ClientReport> reports;
+    for (const auto& client : clients_) {
+        ClientReport report;
+        report.tracker = client->tracker;
+        report.reports = client->reports;
+        // Over the whole test rather than first to last report, so a client that stalled or stopped
+        // receiving part-way shows up as slow.
+        const double span = std::chrono::duration<double>(stopped_ - subscribed_).count();
+        if (span > 0.0) {
+            report.rate_hz = client->reports / span;
+        }
+        report.max_gap_s = client->max_gap_s;
+        if (client->reports > 0) {
+            report.max_gap_s =
+                std::max(report.max_gap_s, std::chrono::duration<double>(stopped_ - client->last_report).count());
+        } else {
+            report.max_gap_s = span;
+        }
+        reports.push_back(report);
+    }
+    return reports;
+}
+
+void LoadTestClients::run() {
+    // VRPN objects are not thread-safe: create, spin and destroy them all on this thread.
+    clients_.clear();
+    for (int i = 0; i < client_count_; ++i) {
+        auto client     = std::make_unique<Client>();
+        client->tracker = trackers_[static_cast<size_t>(i) % trackers_.size()];
+        const std::string address = client->tracker + "@" + server_;
+        // Forced, so every client is its own TCP/UDP endpoint on the server like a separate process.
+        client->connection = vrpn_get_connection_by_name(address.c_str(), nullptr, nullptr, nullptr, nullptr,
+                                                         nullptr, true);
+        if (!client->connection) {
+            std::fprintf(stderr, "Load test: failed to connect client %d to %s\n", i, address.c_str());
+            continue;
+        }
+        client->remote = new vrpn_Tracker_Remote(address.c_str(), client->connection);
+        client->remote->register_change_handler(client.get(), &Client::handle_tracker);
+        clients_.push_back(std::move(client));
+    }
+
+    subscribed_ = std::chrono::steady_clock::now();
+    while (running_) {
+        for (auto& client : clients_) {
+            client->remote->mainloop();
+            client->connection->mainloop();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stopped_ = std::chrono::steady_clock::now();
+
+    for (auto& client : clients_) {
+        client->remote->unregister_change_handler(client.get(), &Client::handle_tracker);
+        delete client->remote;
+        client->remote = nullptr;
+        client->connection->removeReference();
+        client->connection = nullptr;
+    }
+}
+
+}  // namespace vrpn_sim
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <stdexcept>
 
 namespace vrpn_sim {
 namespace {
@@ -38,10 +39,22 @@ void print_help(const char* exe) {
         "      --status-tracker <id>  Tracker index used for status pose output (default 0)\n");
     std::printf("      --auto-restart         Retry binding after errors (default: disabled)\n");
     std::printf("      --restart-delay <s>    Delay before auto-restart (default 1s)\n");
+    std::printf("      --shm <name>           Also publish poses to a same-host shared-memory table\n");
+    std::printf("      --trace <file>         Write a Chrome trace at exit and on SIGUSR1 (tracing builds)\n");
+    std::printf("      --load-test <N>        Connect N in-process VRPN clients, report delivery and tick overrun, exit\n");
+    std::printf("      --load-test-duration <s>  Length of the load test (default 10s)\n");
+    std::printf("      --rt-policy <policy>   'other' (default), 'fifo' or 'rr' for the publish loop\n");
+    std::printf("      --rt-priority <N>      Real-time priority for fifo/rr (default 50)\n");
+    std::printf("      --rt-cpu <N>           Pin the publish loop to CPU N\n");
+    std::printf("      --rt-mlock             Lock all memory with mlockall\n");
+    std::printf("      --rt-jitter-test <s>   Measure loop wake-up jitter without and with the profile, then exit\n");
     std::printf("\nExamples:\n");
     std::printf("  %s --bind :3883 --num-trackers 32 --rate 50\n", prog);
     std::printf("  %s --bind :4000 --auto-restart --restart-delay 2.0\n", prog);
     std::printf("  %s --bind :3883 -q --status-interval 10 --status-mode inline\n", prog);
+    std::printf("  %s --bind :3883 --num-trackers 256 --shm sitl\n", prog);
+    std::printf("  %s --bind :4000 --num-trackers 32 --load-test 200 --load-test-duration 20\n", prog);
+    std::printf("  %s --bind :3883 --rt-policy fifo --rt-priority 80 --rt-cpu 2 --rt-mlock\n", prog);
 }
 
 }  // namespace
@@ -82,6 +95,29 @@ ProgramOptions parse_args(int argc, char** argv) {
             opts.auto_restart = true;
         } else if (std::strcmp(arg, "--restart-delay") == 0 && i + 1 < argc) {
             opts.restart_delay_s = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--shm") == 0 && i + 1 < argc) {
+            opts.shm_name = argv[++i];
+        } else if (std::strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+            opts.trace_path = argv[++i];
+        } else if (std::strcmp(arg, "--load-test") == 0 && i + 1 < argc) {
+            opts.load_test_clients = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--load-test-duration") == 0 && i + 1 < argc) {
+            opts.load_test_duration_s = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--rt-policy") == 0 && i + 1 < argc) {
+            try {
+                opts.realtime.policy = vrpn_common::parse_sched_policy(argv[++i]);
+            } catch (const std::invalid_argument& ex) {
+                std::fprintf(stderr, "%s\n", ex.what());
+                std::exit(1);
+            }
+        } else if (std::strcmp(arg, "--rt-priority") == 0 && i + 1 < argc) {
+            opts.realtime.priority = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--rt-cpu") == 0 && i + 1 < argc) {
+            opts.realtime_cpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--rt-mlock") == 0) {
+            opts.realtime.lock_memory = true;
+        } else if (std::strcmp(arg, "--rt-jitter-test") == 0 && i + 1 < argc) {
+            opts.jitter_test_s = std::atof(argv[++i]);
         } else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
             print_help(argv[0]);
             std::exit(0);
@@ -0,0 +1,31 @@
+#include "vrpn_sim/Trajectory.h"
+
+#include <cmath>
+
+namespace vrpn_sim {
+
+void compute_tracker_sample(int index, double sim_time, TrackerSample& sample) {
+    const double radius = 2.0 + 0.1 * index;
+    const double omega  = 0.2 + 0.01 * index;
+    const double phase  = index * (M_PI / 16.0);
+    const double angle  = omega * sim_time + phase;
+
+    sample.pos[0] = radius * std::cos(angle);
+    sample.pos[1] = radius * std::sin(angle);
+    sample.pos[2] = 1.0 + 0.05 * index;
+
+    const double yaw      = angle;
+    const double half_yaw = yaw * 0.5;
+    sample.quat[0]        = 0.0;
+    sample.quat[1]        = 0.0;
+    sample.quat[2]        = std::sin(half_yaw);
+    sample.quat[3]        = std::cos(half_yaw);
+}
+
+void compute_tracker_samples(double sim_time, TrackerSample* samples, int count) {
+    for (int i = 0; i < count; ++i) {
+        compute_tracker_sample(i, sim_time, samples[i]);
+    }
+}
+
+}  // namespace vrpn_sim
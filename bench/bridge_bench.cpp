@@ -0,0 +1,438 @@
+// Microbenchmarks for the hot paths of the sender and the bridge.
+//
+// Self-contained on purpose (no Google Benchmark dependency), but --json writes the same schema as
+// Google Benchmark so results from two commits can be diffed with its tools/compare.py.
+
+#include "receiver/FrameTransform.h"
+#include "receiver/MavlinkSender.h"
+#include "receiver/PoseMailbox.h"
+#include "receiver/TrackerClient.h"
+#include "vrpn_common/SharedPoseTable.h"
+#include "vrpn_sim/Trajectory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark {
+    Benchmark(std::string name_,
+              std::function<void(size_t)> run_,
+              std::function<void()> setup_    = {},
+              std::function<void()> teardown_ = {})
+        : name(std::move(name_)), run(std::move(run_)), setup(std::move(setup_)), teardown(std::move(teardown_)) {}
+
+    std::string name;
+    // Runs the operation `iterations` times.
+    std::function<void(size_t iterations)> run;
+    // Untimed: build segments, threads and inputs before the first run, release them after the last.
+    std::function<void()> setup;
+    std::function<void()> teardown;
+};
+
+struct Result {
+    std::string name;
+    size_t iterations = 0;
+    double real_ns    = 0.0;  // per iteration, median of the repetitions
+    double cpu_ns     = 0.0;
+};
+
+double thread_cpu_seconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+Result measure(const Benchmark& bench, double min_time_s, int repetitions) {
+    using clock = std::chrono::steady_clock;
+    if (bench.setup) {
+        bench.setup();
+    }
+
+    // Grow the iteration count until one batch lasts min_time_s, like Google Benchmark does.
+    size_t iterations = 1;
+    for (;;) {
+        const auto begin = clock::now();
+        bench.run(iterations);
+        const double elapsed = std::chrono::duration<double>(clock::now() - begin).count();
+        if (elapsed >= min_time_s || iterations >= (size_t{1} << 34)) {
+            break;
+        }
+        const double scale = elapsed > 0.0 ? std::min(10.0, 1.4 * min_time_s / elapsed) : 10.0;
+        iterations         = std::max(iterations + 1, static_cast<size_t>(iterations * scale));
+    }
+
+    std::vector<double> real;
+    std::vector<double> cpu;
+    for (int r = 0; r < repetitions; ++r) {
+        const double cpu_begin = thread_cpu_seconds();
+        const auto begin       = clock::now();
+        bench.run(iterations);
+        real.push_back(std::chrono::duration<double, std::nano>(clock::now() - begin).count() / iterations);
+        cpu.push_back((thread_cpu_seconds() - cpu_begin) * 1e9 / iterations);
+    }
+    if (bench.teardown) {
+        bench.teardown();
+    }
+    std::sort(real.begin(), real.end());
+    std::sort(cpu.begin(), cpu.end());
+    return {bench.name, iterations, real[real.size() / 2], cpu[cpu.size() / 2]};
+}
+
+std::vector<vrpn_TRACKERCB> make_reports(size_t count) {
+    std::vector<vrpn_TRACKERCB> reports(count);
+    for (size_t i = 0; i < count; ++i) {
+        const double yaw = 0.01 * static_cast<double>(i);
+        auto& info       = reports[i];
+        info.msg_time.tv_sec  = 1700000000 + static_cast<long>(i / 50);
+        info.msg_time.tv_usec = static_cast<long>((i % 50) * 20000);
+        info.pos[0]           = std::cos(yaw);
+        info.pos[1]           = std::sin(yaw);
+        info.pos[2]           = 1.0;
+        info.quat[0]          = 0.1 * std::sin(yaw);
+        info.quat[1]          = 0.0;
+        info.quat[2]          = std::sin(yaw * 0.5);
+        info.quat[3]          = std::cos(yaw * 0.5);
+    }
+    return reports;
+}
+
+std::vector<Benchmark> make_benchmarks() {
+    std::vector<Benchmark> benches;
+    const auto reports = make_reports(1024);
+
+    benches.push_back({"quaternion_to_euler", [reports](size_t iterations) {
+                           double roll = 0.0, pitch = 0.0, yaw = 0.0;
+                           for (size_t i = 0; i < iterations; ++i) {
+                               const auto& q = reports[i & 1023].quat;
+                               receiver::quaternion_to_euler(q[0], q[1], q[2], q[3], roll, pitch, yaw);
+                               do_not_optimize(yaw);
+                           }
+                       }});
+
+    benches.push_back({"from_tracker_cb", [reports](size_t iterations) {
+                           for (size_t i = 0; i < iterations; ++i) {
+                               receiver::Pose pose = receiver::from_tracker_cb(reports[i & 1023]);
+                               do_not_optimize(pose);
+                           }
+                       }});
+
+    benches.push_back({"mavlink_pack_vision_position_estimate", [reports](size_t iterations) {
+                           const receiver::Pose pose = receiver::from_tracker_cb(reports[7]);
+                           uint8_t buffer[receiver::kMaxMavlinkFrameLength];
+                           for (size_t i = 0; i < iterations; ++i) {
+                               const uint16_t length = receiver::encode_vision_position_estimate(pose, 1, 1, buffer);
+                               do_not_optimize(length);
+                               do_not_optimize(buffer[0]);
+                           }
+                       }});
+
+    for (size_t trackers : {1, 32, 256, 1024}) {
+        struct TransformState {
+            receiver::FrameTransformStage stage;
+            receiver::PoseBatch pristine;
+            receiver::PoseBatch batch;
+        };
+        auto state  = std::make_shared<TransformState>();
+        auto setup  = [state, reports, trackers]() {
+            receiver::FrameTransformOptions options;
+            options.frame       = receiver::MocapFrame::kEnu;
+            options.body_offset = {0.05, 0.0, -0.02};
+            for (size_t t = 0; t < trackers; ++t) {
+                state->stage.add_tracker(options);
+            }
+            state->pristine.resize(trackers);
+            for (size_t t = 0; t < trackers; ++t) {
+                state->pristine.set(t, receiver::from_tracker_cb(reports[t & 1023]));
+            }
+            state->batch = state->pristine;
+        };
+        auto refill = [state]() {
+            // Only the columns apply() reads; the copy keeps every pass on real tracker poses.
+            auto& in  = state->pristine;
+            auto& out = state->batch;
+            for (auto column : {&receiver::PoseBatch::x, &receiver::PoseBatch::y, &receiver::PoseBatch::z,
+                                &receiver::PoseBatch::qx, &receiver::PoseBatch::qy, &receiver::PoseBatch::qz,
+                                &receiver::PoseBatch::qw}) {
+                std::copy((in.*column).begin(), (in.*column).end(), (out.*column).begin());
+            }
+        };
+        auto teardown = [state]() { *state = TransformState{}; };
+        // The transform needs a fresh input each pass, so it is timed together with the refill and
+        // pose_batch_refill/N times the refill alone; the difference is the transform.
+        benches.push_back({"frame_transform_batch/" + std::to_string(trackers),
+                           [state, refill](size_t iterations) {
+                               for (size_t i = 0; i < iterations; ++i) {
+                                   refill();
+                                   state->stage.apply(state->batch);
+                                   do_not_optimize(state->batch.x[0]);
+                               }
+                           },
+                           setup,
+                           teardown});
+        benches.push_back({"pose_batch_refill/" + std::to_string(trackers),
+                           [state, refill](size_t iterations) {
+                               for (size_t i = 0; i < iterations; ++i) {
+                                   refill();
+                                   do_not_optimize(state->batch.x[0]);
+                               }
+                           },
+                           setup,
+                           teardown});
+    }
+
+    benches.push_back({"pose_handoff/uncontended", [reports](size_t iterations) {
+                           receiver::PoseMailbox mailbox;
+                           const receiver::Pose pose = receiver::from_tracker_cb(reports[3]);
+                           receiver::Pose out;
+                           receiver::PoseMailbox::clock::time_point when;
+                           const auto now = receiver::PoseMailbox::clock::now();
+                           for (size_t i = 0; i < iterations; ++i) {
+                               mailbox.publish(pose, now);
+                               mailbox.read(out, when);
+                               do_not_optimize(out);
+                           }
+                       }});
+
+    {
+        // Reader cost while a writer hammers the mailbox, the worst case for the send loop.
+        struct MailboxState {
+            receiver::PoseMailbox mailbox;
+            std::atomic<bool> running{false};
+            std::thread writer;
+        };
+        auto state = std::make_shared<MailboxState>();
+        benches.push_back({"pose_handoff/contended_read",
+                           [state](size_t iterations) {
+                               receiver::Pose out;
+                               receiver::PoseMailbox::clock::time_point when;
+                               for (size_t i = 0; i < iterations; ++i) {
+                                   state->mailbox.read(out, when);
+                                   do_not_optimize(out);
+                               }
+                           },
+                           [state, reports]() {
+                               const receiver::Pose pose = receiver::from_tracker_cb(reports[3]);
+                               state->running            = true;
+                               state->writer             = std::thread([state, pose]() {
+                                   const auto now = receiver::PoseMailbox::clock::now();
+                                   while (state->running.load(std::memory_order_relaxed)) {
+                                       state->mailbox.publish(pose, now);
+                                   }
+                               });
+                           },
+                           [state]() {
+                               state->running = false;
+                               state->writer.join();
+                           }});
+    }
+
+    // Same round trips as pose_handoff, through the sender→receiver shared-memory table. The segment
+    // is created once per benchmark, outside the timed runs.
+    struct ShmState {
+        std::unique_ptr<vrpn_common::SharedPoseWriter> writer;
+        std::unique_ptr<vrpn_common::SharedPoseReader> reader;
+        std::atomic<bool> running{false};
+        std::thread publisher;
+    };
+    auto open_segment = [](ShmState& state) {
+        const std::string segment = "/bridge_bench_" + std::to_string(::getpid());
+        state.writer = std::make_unique<vrpn_common::SharedPoseWriter>(segment, std::vector<std::string>{"uav0"});
+        state.reader = std::make_unique<vrpn_common::SharedPoseReader>(segment);
+    };
+    const auto report = reports[3];
+    {
+        auto state = std::make_shared<ShmState>();
+        benches.push_back({"shm_pose_handoff/uncontended",
+                           [state, report](size_t iterations) {
+                               vrpn_common::SharedPoseSample out;
+                               uint32_t sequence = 0;
+                               for (size_t i = 0; i < iterations; ++i) {
+                                   state->writer->publish(
+                                       0, report.msg_time.tv_sec, report.msg_time.tv_usec, report.pos, report.quat);
+                                   state->reader->read(0, out, sequence);
+                                   do_not_optimize(out);
+                               }
+                           },
+                           [state, open_segment]() { open_segment(*state); },
+                           [state]() {
+                               state->reader.reset();
+                               state->writer.reset();
+                           }});
+    }
+    {
+        auto state = std::make_shared<ShmState>();
+        benches.push_back({"shm_pose_handoff/contended_read",
+                           [state](size_t iterations) {
+                               vrpn_common::SharedPoseSample out;
+                               uint32_t sequence = 0;
+                               for (size_t i = 0; i < iterations; ++i) {
+                                   state->reader->read(0, out, sequence);
+                                   do_not_optimize(out);
+                               }
+                           },
+                           [state, open_segment, report]() {
+                               open_segment(*state);
+                               state->running   = true;
+                               state->publisher = std::thread([state, report]() {
+                                   while (state->running.load(std::memory_order_relaxed)) {
+                                       state->writer->publish(0, report.msg_time.tv_sec, report.msg_time.tv_usec,
+                                                              report.pos, report.quat);
+                                   }
+                               });
+                           },
+                           [state]() {
+                               state->running = false;
+                               state->publisher.join();
+                               state->reader.reset();
+                               state->writer.reset();
+                           }});
+    }
+
+    for (int trackers : {32, 256}) {
+        benches.push_back({"publish_trackers_kernel/" + std::to_string(trackers), [trackers](size_t iterations) {
+                               std::vector<vrpn_sim::TrackerSample> samples(static_cast<size_t>(trackers));
+                               double sim_time = 0.0;
+                               for (size_t i = 0; i < iterations; ++i) {
+                                   vrpn_sim::compute_tracker_samples(sim_time, samples.data(), trackers);
+                                   do_not_optimize(samples[0]);
+                                   sim_time += 0.02;
+                               }
+                           }});
+    }
+    return benches;
+}
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+bool write_json(const std::string& path, const std::vector<Result>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+    char host[256] = "unknown";
+    ::gethostname(host, sizeof(host) - 1);
+    char date[64];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"host_name\": \"%s\",\n", json_escape(host).c_str());
+    std::fprintf(file, "    \"executable\": \"bridge_bench\",\n");
+    std::fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    std::fprintf(file, "    \"library_build_type\": \"release\"\n");
+#else
+    std::fprintf(file, "    \"library_build_type\": \"debug\"\n");
+#endif
+    std::fprintf(file, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::fprintf(file,
+                     "    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                     "\"repetitions\": 1, \"threads\": 1, \"iterations\": %zu, \"real_time\": %.3f, "
+                     "\"cpu_time\": %.3f, \"time_unit\": \"ns\"}%s\n",
+                     json_escape(r.name).c_str(),
+                     json_escape(r.name).c_str(),
+                     r.iterations,
+                     r.real_ns,
+                     r.cpu_ns,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+void print_usage(const char* exe) {
+    std::printf("Usage: %s [options]\n", exe);
+    std::printf("  --filter <text>       Only run benchmarks whose name contains <text>\n");
+    std::printf("  --min-time <s>        Minimum time per repetition (default 0.2)\n");
+    std::printf("  --repetitions <N>     Repetitions per benchmark, median is reported (default 5)\n");
+    std::printf("  --json <file>         Also write results in Google Benchmark JSON format\n");
+    std::printf("  --list                List benchmark names and exit\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string json_path;
+    double min_time_s = 0.2;
+    int repetitions   = 5;
+    bool list_only    = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(arg, "--min-time") == 0 && i + 1 < argc) {
+            min_time_s = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--repetitions") == 0 && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (std::strcmp(arg, "--list") == 0) {
+            list_only = true;
+        } else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    if (!list_only) {
+        std::printf("%-45s %14s %14s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+    }
+    for (const auto& bench : make_benchmarks()) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        if (list_only) {
+            std::printf("%s\n", bench.name.c_str());
+            continue;
+        }
+        results.push_back(measure(bench, min_time_s, repetitions));
+        const auto& r = results.back();
+        std::printf("%-45s %14.1f %14.1f %12zu\n", r.name.c_str(), r.real_ns, r.cpu_ns, r.iterations);
+        std::fflush(stdout);
+    }
+
+    if (!json_path.empty() && !write_json(json_path, results)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace vrpn_common {
+
+enum class SchedPolicy {
+    kDefault,  // leave the thread on the normal time-sharing scheduler
+    kFifo,
+    kRoundRobin,
+};
+
+SchedPolicy parse_sched_policy(const std::string& name);
+
+struct RealtimeOptions {
+    SchedPolicy policy          = SchedPolicy::kDefault;
+    int priority                = 50;  // clamped to the policy's valid range
+    bool lock_memory            = false;
+    size_t stack_prefault_bytes = 256 * 1024;
+};
+
+// What actually took effect. Missing privileges are not fatal: the failed step is described in
+// `message` and the thread keeps running with default scheduling.
+struct RealtimeReport {
+    bool pinned    = false;
+    bool scheduled = false;
+    std::string message;
+};
+
+// Locks current and future pages (mlockall). Process-wide; call once before spawning threads.
+RealtimeReport lock_process_memory();
+
+// Pins the calling thread to `cpu` (< 0 leaves affinity alone), applies the scheduling policy and
+// touches `stack_prefault_bytes` of stack so the first deep call does not page-fault.
+RealtimeReport apply_thread_profile(const RealtimeOptions& options, int cpu);
+
+struct JitterStats {
+    size_t samples = 0;
+    double min_us  = 0.0;
+    double mean_us = 0.0;
+    double p99_us  = 0.0;
+    double max_us  = 0.0;
+};
+
+// Sleeps to absolute deadlines every `period_s` for `duration_s` on the calling thread and records
+// how late each wake-up was. Same shape as the periodic loops it stands in for.
+JitterStats measure_wakeup_jitter(double period_s, double duration_s);
+
+std::string format_jitter(const JitterStats& stats);
+
+}  // namespace vrpn_common
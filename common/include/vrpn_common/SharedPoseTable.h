@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vrpn_common {
+
+// Same-host pose transport: a POSIX shared-memory segment holding one slot per tracker. Each slot
+// carries the latest sample under a seqlock, so the writer never waits for readers and a reader
+// copies the pose straight out of the mapping with no syscall. Only the newest pose per tracker
+// matters downstream, so slots are overwritten rather than queued.
+
+struct SharedPoseSample {
+    int64_t time_sec  = 0;  // VRPN msg_time of the report
+    int64_t time_usec = 0;
+    double pos[3]     = {0.0, 0.0, 0.0};
+    double quat[4]    = {0.0, 0.0, 0.0, 1.0};
+};
+
+// One cache line pair per slot so neighbouring trackers never share a line.
+struct alignas(64) SharedPoseSlot {
+    std::atomic<uint32_t> sequence{0};  // odd while the writer is inside the slot
+    uint32_t reserved = 0;
+    SharedPoseSample sample;
+};
+static_assert(sizeof(SharedPoseSlot) == 128, "SharedPoseSlot layout is shared between processes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock counter must be address-free");
+
+constexpr size_t kSharedPoseNameLength = 32;
+
+// Adds the leading '/' POSIX expects, so "sitl" and "/sitl" name the same segment.
+std::string shared_pose_segment_name(const std::string& name);
+
+class SharedPoseWriter {
+public:
+    // Creates (or re-creates) the segment with one slot per entry of `tracker_names`. Throws
+    // std::runtime_error if the segment cannot be created or mapped.
+    SharedPoseWriter(const std::string& name, const std::vector<std::string>& tracker_names);
+    ~SharedPoseWriter();  // unmaps and unlinks
+
+    SharedPoseWriter(const SharedPoseWriter&)            = delete;
+    SharedPoseWriter& operator=(const SharedPoseWriter&) = delete;
+
+    size_t size() const { return count_; }
+
+    void publish(size_t slot, int64_t time_sec, int64_t time_usec, const double pos[3], const double quat[4]) {
+        SharedPoseSlot& target = slots_[slot];
+        const uint32_t start   = target.sequence.load(std::memory_order_relaxed);
+        target.sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        target.sample.time_sec  = time_sec;
+        target.sample.time_usec = time_usec;
+        for (int i = 0; i < 3; ++i) {
+            target.sample.pos[i] = pos[i];
+        }
+        for (int i = 0; i < 4; ++i) {
+            target.sample.quat[i] = quat[i];
+        }
+        target.sequence.store(start + 2, std::memory_order_release);
+    }
+
+private:
+    std::string name_;
+    void* mapping_         = nullptr;
+    size_t mapping_size_   = 0;
+    SharedPoseSlot* slots_ = nullptr;
+    size_t count_          = 0;
+};
+
+class SharedPoseReader {
+public:
+    // Maps an existing segment read-only. Throws std::runtime_error if it is missing or malformed.
+    explicit SharedPoseReader(const std::string& name);
+    ~SharedPoseReader();
+
+    SharedPoseReader(const SharedPoseReader&)            = delete;
+    SharedPoseReader& operator=(const SharedPoseReader&) = delete;
+
+    size_t size() const { return count_; }
+    std::string tracker_name(size_t slot) const;
+    int find(const std::string& tracker_name) const;  // slot index or -1
+
+    // True if the segment name now refers to a different object than the one mapped, i.e. the
+    // writer was restarted. Costs an open/fstat; call it only when the slot has gone quiet.
+    bool replaced() const;
+
+    // Copies slot `slot` into `out` if it was written since `last_sequence` (0 = never read) and
+    // updates `last_sequence`. Returns false when nothing new was published, and also when the
+    // slot stays mid-update for kMaxReadAttempts tries: a writer killed inside publish leaves the
+    // sequence odd for good, and the caller's stale/replaced handling must get to run.
+    bool read(size_t slot, SharedPoseSample& out, uint32_t& last_sequence) const {
+        const SharedPoseSlot& source = slots_[slot];
+        for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+            const uint32_t before = source.sequence.load(std::memory_order_acquire);
+            if (before == last_sequence) {
+                return false;
+            }
+            if (before & 1u) {
+                continue;  // writer is mid-update; it holds the slot for a few stores only
+            }
+            out = source.sample;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (source.sequence.load(std::memory_order_relaxed) == before) {
+                last_sequence = before;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A live writer finishes a publish within a few dozen of these; a few hundred is still only
+    // microseconds of spinning.
+    static constexpr int kMaxReadAttempts = 512;
+
+private:
+    std::string name_;
+    void* mapping_               = nullptr;
+    size_t mapping_size_         = 0;
+    const char* names_           = nullptr;
+    const SharedPoseSlot* slots_ = nullptr;
+    size_t count_                = 0;
+    uint64_t device_             = 0;
+    uint64_t inode_              = 0;
+};
+
+}  // namespace vrpn_common
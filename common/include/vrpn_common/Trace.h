@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped event tracing for finding the phase behind a slow tick. Configure with
+// -DVRPN_BRIDGE_TRACING=ON; otherwise every macro below expands to nothing and the functions are
+// empty inlines, so instrumented code costs nothing in a normal build.
+//
+// Each thread records into its own fixed-size ring (the newest events win) with two stores and no
+// lock, so tracing a 2 ms send loop does not perturb it. trace_dump() writes the rings as Chrome
+// trace JSON, loadable in chrome://tracing or ui.perfetto.dev.
+
+namespace vrpn_common {
+
+#ifdef VRPN_BRIDGE_TRACING
+
+uint64_t trace_now_ns();
+// `name` must be a string literal (or otherwise outlive the dump); only the pointer is stored.
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns);
+// Label for the calling thread in the trace viewer.
+void trace_thread_name(const char* name);
+// Writes every recorded event to `path`. Safe to call while other threads keep tracing; events
+// they overwrite during the copy are left out. Concurrent dumps run one after the other. Returns
+// false if the file cannot be written.
+bool trace_dump(const std::string& path);
+// Dumps to `path` at exit and whenever the process receives SIGUSR1 (from a helper thread, so the
+// signal handler itself only sets a flag).
+void trace_install(const std::string& path);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name), start_ns_(trace_now_ns()) {}
+    ~TraceScope() { trace_record(name_, start_ns_, trace_now_ns()); }
+
+    TraceScope(const TraceScope&)            = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+constexpr bool kTracingEnabled = true;
+
+#define VRPN_TRACE_CONCAT_INNER(a, b) a##b
+#define VRPN_TRACE_CONCAT(a, b) VRPN_TRACE_CONCAT_INNER(a, b)
+#define VRPN_TRACE_SCOPE(name) ::vrpn_common::TraceScope VRPN_TRACE_CONCAT(vrpn_trace_scope_, __LINE__)(name)
+
+#else
+
+inline void trace_thread_name(const char*) {}
+inline bool trace_dump(const std::string&) {
+    return false;
+}
+inline void trace_install(const std::string&) {}
+
+constexpr bool kTracingEnabled = false;
+
+#define VRPN_TRACE_SCOPE(name) static_cast<void>(0)
+
+#endif
+
+}  // namespace vrpn_common
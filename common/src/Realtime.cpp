@@ -0,0 +1,149 @@
+#include "vrpn_common/Realtime.h"
+
+#include <algorithm>
+#include <alloca.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+
+namespace vrpn_common {
+namespace {
+
+void append_message(RealtimeReport& report, const std::string& text) {
+    if (!report.message.empty()) {
+        report.message += "; ";
+    }
+    report.message += text;
+}
+
+// Touches `bytes` of fresh stack a page at a time. noinline keeps the alloca in its own frame,
+// which is popped again on return, leaving the pages mapped (and locked under mlockall).
+__attribute__((noinline)) void touch_stack(size_t bytes) {
+    constexpr size_t kPage = 4096;
+    auto* frame            = static_cast<volatile unsigned char*>(alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += kPage) {
+        frame[offset] = 0;
+    }
+}
+
+}  // namespace
+
+SchedPolicy parse_sched_policy(const std::string& name) {
+    if (name == "other" || name == "default") {
+        return SchedPolicy::kDefault;
+    }
+    if (name == "fifo") {
+        return SchedPolicy::kFifo;
+    }
+    if (name == "rr") {
+        return SchedPolicy::kRoundRobin;
+    }
+    throw std::invalid_argument("Unknown scheduling policy: " + name + " (expected other, fifo or rr)");
+}
+
+RealtimeReport lock_process_memory() {
+    RealtimeReport report;
+#ifdef __linux__
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        append_message(report, std::string("mlockall failed (") + std::strerror(errno) +
+                                   "), memory stays pageable; raise RLIMIT_MEMLOCK or grant CAP_IPC_LOCK");
+    }
+#else
+    append_message(report, "mlockall is not supported on this platform, memory stays pageable");
+#endif
+    return report;
+}
+
+RealtimeReport apply_thread_profile(const RealtimeOptions& options, int cpu) {
+    RealtimeReport report;
+
+    if (cpu >= 0) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        const int rc = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        if (rc == 0) {
+            report.pinned = true;
+        } else {
+            append_message(report, "pinning to CPU " + std::to_string(cpu) + " failed (" + std::strerror(rc) + ")");
+        }
+#else
+        append_message(report, "CPU pinning is not supported on this platform");
+#endif
+    }
+
+    if (options.policy != SchedPolicy::kDefault) {
+        const int policy = options.policy == SchedPolicy::kFifo ? SCHED_FIFO : SCHED_RR;
+        sched_param param{};
+        param.sched_priority =
+            std::clamp(options.priority, sched_get_priority_min(policy), sched_get_priority_max(policy));
+        const int rc = ::pthread_setschedparam(::pthread_self(), policy, &param);
+        if (rc == 0) {
+            report.scheduled = true;
+        } else {
+            append_message(report, std::string(policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR") + " priority " +
+                                       std::to_string(param.sched_priority) + " refused (" + std::strerror(rc) +
+                                       "), staying on the default scheduler");
+        }
+    }
+
+    if (options.stack_prefault_bytes > 0) {
+        touch_stack(options.stack_prefault_bytes);
+    }
+    return report;
+}
+
+JitterStats measure_wakeup_jitter(double period_s, double duration_s) {
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(period_s));
+    const auto end =
+        clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(duration_s));
+
+    std::vector<double> lateness_us;
+    lateness_us.reserve(static_cast<size_t>(duration_s / period_s) + 1);
+    auto deadline = clock::now() + period;
+    while (deadline < end) {
+        std::this_thread::sleep_until(deadline);
+        lateness_us.push_back(std::chrono::duration<double, std::micro>(clock::now() - deadline).count());
+        deadline += period;
+    }
+
+    JitterStats stats;
+    stats.samples = lateness_us.size();
+    if (lateness_us.empty()) {
+        return stats;
+    }
+    std::sort(lateness_us.begin(), lateness_us.end());
+    double sum = 0.0;
+    for (double value : lateness_us) {
+        sum += value;
+    }
+    stats.min_us  = lateness_us.front();
+    stats.mean_us = sum / static_cast<double>(lateness_us.size());
+    stats.p99_us  = lateness_us[std::min(lateness_us.size() - 1, static_cast<size_t>(0.99 * lateness_us.size()))];
+    stats.max_us  = lateness_us.back();
+    return stats;
+}
+
+std::string format_jitter(const JitterStats& stats) {
+    char buffer[160];
+    std::snprintf(buffer,
+                  sizeof(buffer),
+                  "samples=%zu wake-up lateness us: min=%.1f mean=%.1f p99=%.1f max=%.1f",
+                  stats.samples,
+                  stats.min_us,
+                  stats.mean_us,
+                  stats.p99_us,
+                  stats.max_us);
+    return buffer;
+}
+
+}  // namespace vrpn_common
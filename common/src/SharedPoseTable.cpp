@@ -0,0 +1,172 @@
+#include "vrpn_common/SharedPoseTable.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vrpn_common {
+namespace {
+
+constexpr char kMagic[8]   = {'V', 'R', 'P', 'N', 'S', 'H', 'M', '1'};
+constexpr uint32_t kVersion = 1;
+
+// Segment layout: header, tracker names (kSharedPoseNameLength each), then the slots, every part
+// starting on a cache line.
+struct alignas(64) SegmentHeader {
+    char magic[8];  // written last, so a reader never sees a half-initialised segment as valid
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    uint32_t name_length;
+};
+
+size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t names_offset() {
+    return sizeof(SegmentHeader);
+}
+
+size_t slots_offset(size_t count) {
+    return align_up(names_offset() + count * kSharedPoseNameLength, alignof(SharedPoseSlot));
+}
+
+size_t segment_size(size_t count) {
+    return slots_offset(count) + count * sizeof(SharedPoseSlot);
+}
+
+std::runtime_error segment_error(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " shared-memory segment " + name + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+std::string shared_pose_segment_name(const std::string& name) {
+    if (!name.empty() && name.front() == '/') {
+        return name;
+    }
+    return "/" + name;
+}
+
+SharedPoseWriter::SharedPoseWriter(const std::string& name, const std::vector<std::string>& tracker_names)
+    : name_(shared_pose_segment_name(name)), count_(tracker_names.size()) {
+    // Start from a fresh object: a reader still mapping an old one notices via replaced().
+    ::shm_unlink(name_.c_str());
+    const int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw segment_error("Failed to create", name_);
+    }
+    mapping_size_ = segment_size(count_);
+    if (::ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name_.c_str());
+        throw segment_error("Failed to size", name_);
+    }
+    mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        ::shm_unlink(name_.c_str());
+        throw segment_error("Failed to map", name_);
+    }
+
+    auto* base          = static_cast<char*>(mapping_);
+    auto* header        = new (base) SegmentHeader{};
+    header->version     = kVersion;
+    header->slot_count  = static_cast<uint32_t>(count_);
+    header->slot_size   = sizeof(SharedPoseSlot);
+    header->name_length = kSharedPoseNameLength;
+    for (size_t i = 0; i < count_; ++i) {
+        std::strncpy(base + names_offset() + i * kSharedPoseNameLength, tracker_names[i].c_str(),
+                     kSharedPoseNameLength - 1);
+    }
+    slots_ = reinterpret_cast<SharedPoseSlot*>(base + slots_offset(count_));
+    for (size_t i = 0; i < count_; ++i) {
+        new (&slots_[i]) SharedPoseSlot{};
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+}
+
+SharedPoseWriter::~SharedPoseWriter() {
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+        ::shm_unlink(name_.c_str());
+    }
+}
+
+SharedPoseReader::SharedPoseReader(const std::string& name) : name_(shared_pose_segment_name(name)) {
+    const int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw segment_error("Failed to open", name_);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SegmentHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Shared-memory segment " + name_ + " is not initialised");
+    }
+    device_       = static_cast<uint64_t>(info.st_dev);
+    inode_        = static_cast<uint64_t>(info.st_ino);
+    mapping_size_ = static_cast<size_t>(info.st_size);
+    mapping_      = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw segment_error("Failed to map", name_);
+    }
+
+    const auto* base   = static_cast<const char*>(mapping_);
+    const auto* header = reinterpret_cast<const SegmentHeader*>(base);
+    const bool valid   = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 && header->version == kVersion &&
+                       header->slot_size == sizeof(SharedPoseSlot) && header->name_length == kSharedPoseNameLength &&
+                       segment_size(header->slot_count) <= mapping_size_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        throw std::runtime_error("Shared-memory segment " + name_ + " is not a pose table (or not ready yet)");
+    }
+    count_ = header->slot_count;
+    names_ = base + names_offset();
+    slots_ = reinterpret_cast<const SharedPoseSlot*>(base + slots_offset(count_));
+}
+
+SharedPoseReader::~SharedPoseReader() {
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+}
+
+std::string SharedPoseReader::tracker_name(size_t slot) const {
+    const char* name = names_ + slot * kSharedPoseNameLength;
+    return std::string(name, ::strnlen(name, kSharedPoseNameLength));
+}
+
+int SharedPoseReader::find(const std::string& tracker_name) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (this->tracker_name(i) == tracker_name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool SharedPoseReader::replaced() const {
+    const int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return true;
+    }
+    struct stat info {};
+    const bool same = ::fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_dev) == device_ &&
+                      static_cast<uint64_t>(info.st_ino) == inode_;
+    ::close(fd);
+    return !same;
+}
+
+}  // namespace vrpn_common
@@ -0,0 +1,171 @@
+#include "vrpn_common/Trace.h"
+
+#ifdef VRPN_BRIDGE_TRACING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace vrpn_common {
+namespace {
+
+// Per thread; a power of two so the slot is a mask. 64 Ki events cover well over a minute of the
+// busiest loop at 24 bytes each.
+constexpr uint64_t kRingCapacity = 1u << 16;
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// The dump may read a slot while its owner overwrites it. Relaxed atomics make that a stale or
+// mixed read instead of a data race (they compile to plain moves); the head check in trace_dump
+// throws such slots away.
+struct TraceSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+};
+
+// Single producer (the owning thread), read by trace_dump. The producer fills slot `head` and only
+// then publishes head + 1, so everything below head is complete unless it has since been lapped.
+struct TraceRing {
+    std::atomic<uint64_t> head{0};
+    std::unique_ptr<TraceSlot[]> events{new TraceSlot[kRingCapacity]};
+    uint32_t tid = 0;
+    std::atomic<const char*> name{nullptr};
+};
+
+const auto g_epoch = std::chrono::steady_clock::now();
+
+std::mutex g_registry_mutex;
+std::vector<std::shared_ptr<TraceRing>> g_registry;  // rings outlive their threads for the dump
+
+// SIGUSR1 and exit can both dump; one at a time, or they would write the same file at once.
+std::mutex g_dump_mutex;
+std::string g_dump_path;
+std::atomic<bool> g_dump_requested{false};
+
+TraceRing& local_ring() {
+    thread_local std::shared_ptr<TraceRing> ring = [] {
+        auto created = std::make_shared<TraceRing>();
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        created->tid = static_cast<uint32_t>(g_registry.size() + 1);
+        g_registry.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+void handle_dump_signal(int) {
+    g_dump_requested.store(true);
+}
+
+void dump_at_exit() {
+    trace_dump(g_dump_path);
+}
+
+}  // namespace
+
+uint64_t trace_now_ns() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count());
+}
+
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    TraceRing& ring     = local_ring();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    TraceSlot& slot     = ring.events[head & (kRingCapacity - 1)];
+    // A dump that reads any of the stores below then also sees every head published before them.
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void trace_thread_name(const char* name) {
+    local_ring().name.store(name, std::memory_order_relaxed);
+}
+
+bool trace_dump(const std::string& path) {
+    std::lock_guard<std::mutex> dump_lock(g_dump_mutex);
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        rings = g_registry;
+    }
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    const long pid = static_cast<long>(::getpid());
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first_event = true;
+    auto separator   = [&]() {
+        const char* text = first_event ? "" : ",\n";
+        first_event      = false;
+        return text;
+    };
+
+    std::vector<TraceEvent> copy;
+    for (const auto& ring : rings) {
+        if (const char* name = ring->name.load(std::memory_order_relaxed)) {
+            std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         separator(), pid, ring->tid, name);
+        }
+        const uint64_t end   = ring->head.load(std::memory_order_acquire);
+        const uint64_t begin = end > kRingCapacity ? end - kRingCapacity : 0;
+        copy.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            const TraceSlot& slot = ring->events[i & (kRingCapacity - 1)];
+            copy.push_back(TraceEvent{slot.name.load(std::memory_order_relaxed),
+                                      slot.start_ns.load(std::memory_order_relaxed),
+                                      slot.end_ns.load(std::memory_order_relaxed)});
+        }
+        // Slots the owner reused while we copied (including the one it may be writing) are dropped.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t now_head = ring->head.load(std::memory_order_acquire);
+        const uint64_t valid    = now_head >= kRingCapacity ? now_head - kRingCapacity + 1 : 0;
+        for (uint64_t i = std::max(begin, valid); i < end; ++i) {
+            const TraceEvent& event = copy[i - begin];
+            std::fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%ld,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         separator(), event.name, pid, ring->tid, event.start_ns / 1000.0,
+                         (event.end_ns - event.start_ns) / 1000.0);
+        }
+    }
+    std::fprintf(out, "\n]}\n");
+    return std::fclose(out) == 0;
+}
+
+void trace_install(const std::string& path) {
+    g_dump_path = path;
+    std::signal(SIGUSR1, handle_dump_signal);
+    std::atexit(dump_at_exit);
+    std::thread([]() {
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (g_dump_requested.exchange(false)) {
+                if (trace_dump(g_dump_path)) {
+                    std::fprintf(stderr, "Trace written to %s\n", g_dump_path.c_str());
+                } else {
+                    std::fprintf(stderr, "Failed to write trace %s\n", g_dump_path.c_str());
+                }
+            }
+        }
+    }).detach();
+}
+
+}  // namespace vrpn_common
+
+#endif  // VRPN_BRIDGE_TRACING
@@ -0,0 +1,555 @@
+// Emulated serial flight controller on a pseudo-terminal.
+//
+// The PTY slave stands in for the FC's UART: point vrpn_receiver or vrpn_replay at the printed
+// device. The master side is drained at baud/10 bytes per second, so frames queue in the tty the way
+// they do in front of a real UART, and every MAVLink frame is parsed and timed on arrival.
+//
+// --self-test drives an in-process MavlinkSender through the PTY at each baud rate: a paced phase at
+// --rate reports queueing latency and saturation, then an overload phase fills the tty until the
+// writer hits partial writes and EAGAIN. The run fails if a frame arrives torn or goes missing
+// without the writer having counted it as dropped, or if no write was ever split (the pending-tail
+// path went untested). A last phase adds a mirror on a PTY read at 1/16 of the fastest baud and
+// offers 4x what the mirror can carry until it drops: the mirror must count every frame it loses
+// while the FC link loses none.
+
+#include "receiver/MavlinkSender.h"
+
+#include <common/mavlink.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t g_should_exit = 0;
+
+void handle_signal(int) {
+    g_should_exit = 1;
+}
+
+using clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<int> bauds = {57600, 115200, 921600};
+    bool self_test         = false;
+    bool heartbeat         = false;
+    bool timesync          = false;
+    double rate_hz         = 100.0;  // offered load in the self-test paced phase
+    double duration_s      = 2.0;
+    double status_interval = 1.0;
+};
+
+struct FcStats {
+    uint64_t bytes            = 0;
+    uint64_t frames           = 0;
+    uint64_t vision_frames    = 0;
+    uint64_t crc_errors       = 0;
+    uint64_t seq_gaps         = 0;  // frames the sequence numbers say were sent but never arrived
+    uint64_t timesync_replies = 0;
+    double first_arrival_us   = 0.0;
+    double last_arrival_us    = 0.0;
+    std::vector<double> latency_ms;
+};
+
+double wall_clock_us() {
+    using namespace std::chrono;
+    return static_cast<double>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+class EmulatedFc {
+public:
+    EmulatedFc(int baud_rate, bool heartbeat, bool timesync)
+        : bytes_per_s_(baud_rate / 10.0), heartbeat_(heartbeat), timesync_(timesync) {
+        master_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || ::grantpt(master_) != 0 || ::unlockpt(master_) != 0) {
+            throw std::runtime_error(std::string("Failed to create pseudo-terminal: ") + std::strerror(errno));
+        }
+        device_ = ::ptsname(master_);
+        ::fcntl(master_, F_SETFL, ::fcntl(master_, F_GETFL) | O_NONBLOCK);
+
+        // Hold the slave open in raw mode so the link is binary-clean before the writer attaches and
+        // the master never sees a hang-up when the writer closes it.
+        slave_ = ::open(device_.c_str(), O_RDWR | O_NOCTTY);
+        termios tty{};
+        if (slave_ < 0 || ::tcgetattr(slave_, &tty) != 0) {
+            throw std::runtime_error("Failed to open " + device_);
+        }
+        ::cfmakeraw(&tty);
+        ::tcsetattr(slave_, TCSANOW, &tty);
+        last_seq_.fill(-1);
+    }
+
+    ~EmulatedFc() {
+        stop();
+        ::close(slave_);
+        ::close(master_);
+    }
+
+    const std::string& device() const { return device_; }
+
+    void start() {
+        running_ = true;
+        thread_  = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // Unpaced reads drain whatever is queued as fast as the PTY hands it over.
+    void set_paced(bool paced) { paced_ = paced; }
+
+    double idle_s() const {
+        const auto last = clock::time_point(clock::duration(last_byte_.load()));
+        return std::chrono::duration<double>(clock::now() - last).count();
+    }
+
+    FcStats take_stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FcStats out = std::move(stats_);
+        stats_      = FcStats{};
+        return out;
+    }
+
+private:
+    void run() {
+        const auto tick            = std::chrono::milliseconds(1);
+        const double budget_cap    = std::max(bytes_per_s_ * 0.002, 1.0);
+        double budget              = 0.0;
+        auto next                  = clock::now();
+        auto next_heartbeat        = next;
+        uint8_t buffer[4096];
+        while (running_) {
+            next += tick;
+            const auto now = clock::now();
+            if (next < now) {
+                next = now;  // fell behind (descheduled); do not bank the missed ticks
+            }
+            std::this_thread::sleep_until(next);
+
+            const bool paced = paced_;
+            if (paced) {
+                budget = std::min(budget + bytes_per_s_ * 0.001, budget_cap);
+            }
+            for (;;) {
+                const size_t allowed = paced ? static_cast<size_t>(budget) : sizeof(buffer);
+                if (allowed == 0) {
+                    break;
+                }
+                const ssize_t n = ::read(master_, buffer, std::min(allowed, sizeof(buffer)));
+                if (n <= 0) {
+                    break;
+                }
+                if (paced) {
+                    budget -= static_cast<double>(n);
+                }
+                last_byte_ = clock::now().time_since_epoch().count();
+                consume(buffer, static_cast<size_t>(n), wall_clock_us());
+                if (paced) {
+                    break;
+                }
+            }
+
+            if (heartbeat_ && clock::now() >= next_heartbeat) {
+                next_heartbeat += std::chrono::seconds(1);
+                mavlink_message_t message{};
+                mavlink_msg_heartbeat_pack_chan(1, 1, MAVLINK_COMM_1, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4,
+                                                0, 0, MAV_STATE_ACTIVE);
+                write_master(message);
+            }
+        }
+    }
+
+    void consume(const uint8_t* data, size_t length, double arrival_us) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.bytes += length;
+        for (size_t i = 0; i < length; ++i) {
+            mavlink_message_t message{};
+            mavlink_status_t status{};
+            const uint8_t result = mavlink_frame_char_buffer(&rx_message_, &rx_status_, data[i], &message, &status);
+            if (result == MAVLINK_FRAMING_BAD_CRC) {
+                stats_.crc_errors += 1;
+                continue;
+            }
+            if (result != MAVLINK_FRAMING_OK) {
+                continue;
+            }
+
+            stats_.frames += 1;
+            int16_t& last = last_seq_[message.sysid];
+            if (last >= 0) {
+                stats_.seq_gaps += static_cast<uint8_t>(message.seq - last - 1);
+            }
+            last = message.seq;
+
+            if (message.msgid == MAVLINK_MSG_ID_VISION_POSITION_ESTIMATE) {
+                const uint64_t usec = mavlink_msg_vision_position_estimate_get_usec(&message);
+                stats_.vision_frames += 1;
+                stats_.latency_ms.push_back((arrival_us - static_cast<double>(usec)) / 1000.0);
+                if (stats_.first_arrival_us == 0.0) {
+                    stats_.first_arrival_us = arrival_us;
+                }
+                stats_.last_arrival_us = arrival_us;
+            } else if (message.msgid == MAVLINK_MSG_ID_TIMESYNC && timesync_) {
+                mavlink_timesync_t request;
+                mavlink_msg_timesync_decode(&message, &request);
+                if (request.tc1 == 0) {
+                    mavlink_message_t reply{};
+                    mavlink_msg_timesync_pack_chan(1, 1, MAVLINK_COMM_1, &reply,
+                                                   static_cast<int64_t>(arrival_us * 1000.0), request.ts1,
+                                                   message.sysid, message.compid);
+                    write_master(reply);
+                    stats_.timesync_replies += 1;
+                }
+            }
+        }
+    }
+
+    // Best effort: nothing reads the slave's input in a one-way bridge, so a full buffer is ignored.
+    void write_master(const mavlink_message_t& message) {
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        const uint16_t length = mavlink_msg_to_send_buffer(buffer, &message);
+        if (::write(master_, buffer, length) < 0) {
+            return;
+        }
+    }
+
+    int master_ = -1;
+    int slave_  = -1;
+    std::string device_;
+    double bytes_per_s_ = 0.0;
+    bool heartbeat_     = false;
+    bool timesync_      = false;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> paced_{true};
+    std::atomic<clock::rep> last_byte_{0};
+    std::thread thread_;
+
+    std::mutex mutex_;
+    FcStats stats_;
+    mavlink_message_t rx_message_{};
+    mavlink_status_t rx_status_{};
+    std::array<int16_t, 256> last_seq_{};
+};
+
+void print_usage(const char* exe) {
+    std::printf("Usage: %s [options]\n", exe);
+    std::printf("  --baud <rate[,rate...]>  Link speed(s); standalone mode uses the first (default 57600,115200,921600)\n");
+    std::printf("  --heartbeat              Send HEARTBEAT at 1 Hz\n");
+    std::printf("  --timesync               Answer TIMESYNC requests\n");
+    std::printf("  --status-interval <s>    Standalone statistics period (default 1)\n");
+    std::printf("  --self-test              Drive an in-process MavlinkSender through the PTY and check the link\n");
+    std::printf("  --rate <Hz>              Self-test offered pose rate (default 100)\n");
+    std::printf("  --duration <s>           Self-test paced phase per baud rate (default 2)\n");
+}
+
+std::vector<int> parse_bauds(const std::string& list) {
+    std::vector<int> bauds;
+    size_t start = 0;
+    while (start <= list.size()) {
+        const size_t comma = list.find(',', start);
+        const std::string item = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (!item.empty()) {
+            bauds.push_back(std::atoi(item.c_str()));
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return bauds;
+}
+
+Options parse_args(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value      = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s requires a value\n", arg);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (std::strcmp(arg, "--baud") == 0) {
+            opts.bauds = parse_bauds(value());
+        } else if (std::strcmp(arg, "--heartbeat") == 0) {
+            opts.heartbeat = true;
+        } else if (std::strcmp(arg, "--timesync") == 0) {
+            opts.timesync = true;
+        } else if (std::strcmp(arg, "--status-interval") == 0) {
+            opts.status_interval = std::atof(value());
+        } else if (std::strcmp(arg, "--self-test") == 0) {
+            opts.self_test = true;
+        } else if (std::strcmp(arg, "--rate") == 0) {
+            opts.rate_hz = std::atof(value());
+        } else if (std::strcmp(arg, "--duration") == 0) {
+            opts.duration_s = std::atof(value());
+        } else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            std::exit(2);
+        }
+    }
+    if (opts.bauds.empty()) {
+        std::fprintf(stderr, "--baud needs at least one rate\n");
+        std::exit(2);
+    }
+    return opts;
+}
+
+receiver::Pose pose_now() {
+    receiver::Pose pose;
+    pose.timestamp_sec = wall_clock_us() / 1e6;
+    pose.x             = 1.0;
+    pose.y             = -2.0;
+    pose.z             = -0.5;
+    // A non-zero attitude keeps MAVLink 2 from trimming the frame to 32 bytes. The kernel queues
+    // tty data in 256-byte buffers, which 32-byte frames fill exactly, so no write would ever be
+    // split; 44-byte frames straddle buffer ends and produce the partial writes the test needs.
+    pose.roll  = 0.01;
+    pose.pitch = -0.02;
+    pose.yaw   = 1.5;
+    return pose;
+}
+
+// Offers `frames_per_s` for `duration_s` in 1 ms batches so high rates do not depend on sleep
+// granularity.
+void offer_load(receiver::MavlinkSender& sender, double frames_per_s, double duration_s,
+                const std::function<bool()>& done = {}) {
+    const auto start = clock::now();
+    const auto end   = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(duration_s));
+    auto next        = start;
+    double owed      = 0.0;
+    while (!g_should_exit && clock::now() < end && !(done && done())) {
+        next += std::chrono::milliseconds(1);
+        std::this_thread::sleep_until(next);
+        owed += frames_per_s * 0.001;
+        for (; owed >= 1.0; owed -= 1.0) {
+            sender.send_pose(pose_now());
+        }
+        sender.flush_pending();
+    }
+}
+
+// Waits until the writer has nothing pending and the FC has gone quiet.
+void drain(receiver::MavlinkSender& sender, EmulatedFc& fc, double timeout_s) {
+    const auto start    = clock::now();
+    const auto deadline = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeout_s));
+    while (clock::now() < deadline) {
+        const bool settled = clock::now() - start > std::chrono::milliseconds(100) && fc.idle_s() > 0.1;
+        if (sender.flush_pending() && settled) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+bool run_mirror_check(const Options& opts, double frame_bytes) {
+    const int fc_baud     = *std::max_element(opts.bauds.begin(), opts.bauds.end());
+    const int mirror_baud = fc_baud / 16;
+    EmulatedFc fc(fc_baud, false, false);
+    EmulatedFc mirror(mirror_baud, false, false);
+    fc.start();
+    mirror.start();
+
+    receiver::MavlinkOptions link;
+    link.link_type     = "serial";
+    link.serial_device = fc.device();
+    link.baud_rate     = fc_baud;
+    link.mirrors       = {"serial:" + mirror.device() + ":" + std::to_string(mirror_baud)};
+    receiver::MavlinkSender sender(link);
+    const double offered_hz = 4.0 * mirror_baud / 10.0 / frame_bytes;
+
+    offer_load(sender, offered_hz, 30.0, [&]() { return sender.mirror_stats(0).frames_dropped >= 50; });
+    drain(sender, fc, 30.0);
+    drain(sender, mirror, 30.0);
+    sender.send_pose(pose_now());
+    drain(sender, fc, 30.0);
+    drain(sender, mirror, 30.0);
+    const FcStats at_fc                   = fc.take_stats();
+    const FcStats at_mirror               = mirror.take_stats();
+    const receiver::LinkStats fc_link     = sender.link_stats();
+    const receiver::LinkStats mirror_link = sender.mirror_stats(0);
+    fc.stop();
+    mirror.stop();
+
+    const bool ok = at_fc.crc_errors == 0 && at_mirror.crc_errors == 0 && fc_link.frames_dropped == 0 &&
+                    at_fc.vision_frames == fc_link.frames_sent && at_fc.seq_gaps == 0 &&
+                    at_mirror.vision_frames == mirror_link.frames_sent &&
+                    at_mirror.seq_gaps == mirror_link.frames_dropped && mirror_link.frames_dropped > 0;
+    std::printf("[fc_emulator] mirror %d baud next to FC %d baud: %s offered=%.0f Hz\n",
+                mirror_baud,
+                fc_baud,
+                ok ? "PASS" : "FAIL",
+                offered_hz);
+    std::printf("[fc_emulator]   fc     sent=%llu received=%llu dropped=%llu latency ms p99=%.2f max=%.2f\n",
+                static_cast<unsigned long long>(fc_link.frames_sent),
+                static_cast<unsigned long long>(at_fc.vision_frames),
+                static_cast<unsigned long long>(fc_link.frames_dropped),
+                percentile(at_fc.latency_ms, 0.99),
+                percentile(at_fc.latency_ms, 1.0));
+    std::printf("[fc_emulator]   mirror sent=%llu received=%llu dropped=%llu seq_gaps=%llu\n",
+                static_cast<unsigned long long>(mirror_link.frames_sent),
+                static_cast<unsigned long long>(at_mirror.vision_frames),
+                static_cast<unsigned long long>(mirror_link.frames_dropped),
+                static_cast<unsigned long long>(at_mirror.seq_gaps));
+    return ok;
+}
+
+int run_self_test(const Options& opts) {
+    uint8_t probe[receiver::kMaxMavlinkFrameLength];
+    const double frame_bytes = receiver::encode_vision_position_estimate(pose_now(), 1, 1, probe);
+
+    bool pass = true;
+    for (int baud : opts.bauds) {
+        EmulatedFc fc(baud, opts.heartbeat, opts.timesync);
+        fc.start();
+
+        receiver::MavlinkOptions link;
+        link.link_type     = "serial";
+        link.serial_device = fc.device();
+        link.baud_rate     = baud;
+        receiver::MavlinkSender sender(link);
+        const double capacity_hz = baud / 10.0 / frame_bytes;
+
+        // Paced phase: realistic queueing at the requested rate, FC reading at line speed.
+        offer_load(sender, opts.rate_hz, opts.duration_s);
+        drain(sender, fc, 30.0);
+        const FcStats paced               = fc.take_stats();
+        const receiver::LinkStats at_paced = sender.link_stats();
+        const double span_s = std::max(paced.last_arrival_us - paced.first_arrival_us, 1.0) / 1e6;
+
+        // Overload phase: offer 4x line capacity until the tty is full and the writer has dropped
+        // a few hundred frames. Runs of drops stay far below the 256-frame sequence wrap.
+        const uint64_t dropped_before = at_paced.frames_dropped;
+        offer_load(sender, 4.0 * capacity_hz, 30.0,
+                   [&]() { return sender.link_stats().frames_dropped - dropped_before >= 200; });
+        fc.set_paced(false);
+        drain(sender, fc, 30.0);
+        // One last frame into the empty tty, so drops at the very end show up as a sequence gap.
+        sender.send_pose(pose_now());
+        drain(sender, fc, 30.0);
+        const FcStats overload          = fc.take_stats();
+        const receiver::LinkStats total = sender.link_stats();
+        fc.stop();
+
+        const uint64_t received = paced.vision_frames + overload.vision_frames;
+        const uint64_t gaps     = paced.seq_gaps + overload.seq_gaps;
+        const uint64_t crc      = paced.crc_errors + overload.crc_errors;
+        const bool ok           = crc == 0 && received == total.frames_sent && gaps == total.frames_dropped &&
+                        total.frames_dropped > dropped_before && total.partial_writes > 0;
+        pass = pass && ok;
+
+        std::printf("[fc_emulator] %7d baud: %s capacity=%.0f Hz (%.0f-byte frames)\n",
+                    baud,
+                    ok ? "PASS" : "FAIL",
+                    capacity_hz,
+                    frame_bytes);
+        std::printf("[fc_emulator]   paced    offered=%.0f Hz delivered=%.1f Hz latency ms p50=%.2f p99=%.2f max=%.2f "
+                    "dropped=%llu partial_writes=%llu\n",
+                    opts.rate_hz,
+                    paced.vision_frames / std::max(span_s, opts.duration_s),
+                    percentile(paced.latency_ms, 0.5),
+                    percentile(paced.latency_ms, 0.99),
+                    percentile(paced.latency_ms, 1.0),
+                    static_cast<unsigned long long>(at_paced.frames_dropped),
+                    static_cast<unsigned long long>(at_paced.partial_writes));
+        std::printf("[fc_emulator]   overload sent=%llu received=%llu dropped=%llu seq_gaps=%llu partial_writes=%llu "
+                    "crc_errors=%llu queue latency max=%.0f ms\n",
+                    static_cast<unsigned long long>(total.frames_sent),
+                    static_cast<unsigned long long>(received),
+                    static_cast<unsigned long long>(total.frames_dropped),
+                    static_cast<unsigned long long>(gaps),
+                    static_cast<unsigned long long>(total.partial_writes),
+                    static_cast<unsigned long long>(crc),
+                    percentile(overload.latency_ms, 1.0));
+        if (g_should_exit) {
+            break;
+        }
+    }
+    if (!g_should_exit) {
+        pass = run_mirror_check(opts, frame_bytes) && pass;
+    }
+    std::printf("[fc_emulator] %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+int run_standalone(const Options& opts) {
+    const int baud = opts.bauds.front();
+    EmulatedFc fc(baud, opts.heartbeat, opts.timesync);
+    fc.start();
+    std::printf("[fc_emulator] emulated FC on %s at %d baud\n", fc.device().c_str(), baud);
+    std::printf("[fc_emulator]   vrpn_receiver --link serial --device %s --baud %d ...\n", fc.device().c_str(), baud);
+    std::fflush(stdout);
+
+    const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(opts.status_interval));
+    auto next           = clock::now() + interval;
+    while (!g_should_exit) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (clock::now() < next) {
+            continue;
+        }
+        next += interval;
+        const FcStats stats = fc.take_stats();
+        std::printf("[fc_emulator] frames=%llu vision=%.1f Hz line=%.0f%% latency ms p50=%.2f p99=%.2f max=%.2f "
+                    "seq_gaps=%llu crc_errors=%llu timesync=%llu\n",
+                    static_cast<unsigned long long>(stats.frames),
+                    stats.vision_frames / opts.status_interval,
+                    100.0 * stats.bytes / (baud / 10.0 * opts.status_interval),
+                    percentile(stats.latency_ms, 0.5),
+                    percentile(stats.latency_ms, 0.99),
+                    percentile(stats.latency_ms, 1.0),
+                    static_cast<unsigned long long>(stats.seq_gaps),
+                    static_cast<unsigned long long>(stats.crc_errors),
+                    static_cast<unsigned long long>(stats.timesync_replies));
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    const Options opts = parse_args(argc, argv);
+    try {
+        return opts.self_test ? run_self_test(opts) : run_standalone(opts);
+    } catch (const std::exception& ex) {
+        std::fprintf(stderr, "Error: %s\n", ex.what());
+        return 1;
+    }
+}
@@ -0,0 +1,482 @@
+// End-to-end loopback check: fake_vrpn_uav_server → N × vrpn_receiver → local UDP sinks.
+//
+// Every sink parses the MAVLink stream with the vendored parser and measures delivered rate,
+// transport loss (sequence gaps), duplicate poses (same timestamp sent twice) and latency from the
+// sender's VRPN timestamp to arrival at the sink. Exits non-zero when any threshold is missed.
+//
+// With --control the first receiver also gets a control socket, and during the measurement window
+// the harness adds one more tracker to it, removes it and adds it again. Both vehicles on that link
+// must then keep their own unbroken MAVLink sequence, and nothing may arrive from the removed one.
+
+#include <common/mavlink.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <netinet/in.h>
+#include <poll.h>
+#include <spawn.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+namespace {
+
+#ifndef VRPN_SENDER_BIN
+#define VRPN_SENDER_BIN "fake_vrpn_uav_server"
+#endif
+#ifndef VRPN_RECEIVER_BIN
+#define VRPN_RECEIVER_BIN "vrpn_receiver"
+#endif
+
+struct Options {
+    std::string sender_bin   = VRPN_SENDER_BIN;
+    std::string receiver_bin = VRPN_RECEIVER_BIN;
+    int vrpn_port            = 4000;
+    int receivers            = 2;
+    double sender_rate_hz    = 50.0;
+    double receiver_rate_hz  = 20.0;
+    double warmup_s          = 2.0;
+    double duration_s        = 5.0;
+    std::string shm_name;  // run the pair over the shared-memory table instead of VRPN
+    bool control             = false;
+    bool verbose             = false;
+
+    // Pass/fail thresholds.
+    double min_rate_ratio     = 0.9;   // delivered / requested receiver rate
+    double max_loss_ratio     = 0.01;  // MAVLink sequence gaps / frames sent
+    double max_duplicate_ratio = 0.05; // frames repeating the previous pose timestamp
+    double max_p99_latency_ms = 100.0;
+};
+
+struct SinkStats {
+    uint64_t frames      = 0;
+    uint64_t lost        = 0;
+    uint64_t duplicates  = 0;
+    std::vector<double> latency_ms;
+};
+
+// One system ID on a sink; MAVLink sequence numbers are counted per sender system.
+struct Stream {
+    bool have_seq        = false;
+    uint8_t last_seq     = 0;
+    uint64_t last_usec   = 0;
+    SinkStats stats;
+};
+
+struct Sink {
+    int socket = -1;
+    uint16_t port = 0;
+    mavlink_message_t rx_message{};
+    mavlink_status_t rx_status{};
+    uint64_t crc_errors = 0;
+    std::map<uint8_t, Stream> streams;
+};
+
+double wall_clock_us() {
+    using namespace std::chrono;
+    return static_cast<double>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+void print_usage(const char* exe) {
+    std::printf("Usage: %s [options]\n", exe);
+    std::printf("  --sender <path>            fake_vrpn_uav_server binary (default: build tree)\n");
+    std::printf("  --receiver <path>          vrpn_receiver binary (default: build tree)\n");
+    std::printf("  --port <port>              VRPN port for the sender (default 4000)\n");
+    std::printf("  --receivers <N>            Receivers to start, forwarding uav0..uavN-1 (default 2)\n");
+    std::printf("  --sender-rate <Hz>         Sender publish rate (default 50)\n");
+    std::printf("  --rate <Hz>                Receiver send rate (default 20)\n");
+    std::printf("  --warmup <s>               Ignore frames for this long after start (default 2)\n");
+    std::printf("  --duration <s>             Measurement window (default 5)\n");
+    std::printf("  --min-rate-ratio <r>       Fail below this share of --rate (default 0.9)\n");
+    std::printf("  --max-loss <r>             Fail above this sequence-gap ratio (default 0.01)\n");
+    std::printf("  --max-duplicates <r>       Fail above this duplicate-pose ratio (default 0.05)\n");
+    std::printf("  --max-p99-latency-ms <ms>  Fail above this p99 sender→sink latency (default 100)\n");
+    std::printf("  --shm <name>               Forward over the shared-memory pose table instead of VRPN\n");
+    std::printf("  --control                  Add, remove and re-add a tracker over the first receiver's control socket\n");
+    std::printf("  --verbose                  Show sender/receiver output\n");
+}
+
+Options parse_args(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto value      = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s requires a value\n", arg);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (std::strcmp(arg, "--sender") == 0) {
+            opts.sender_bin = value();
+        } else if (std::strcmp(arg, "--receiver") == 0) {
+            opts.receiver_bin = value();
+        } else if (std::strcmp(arg, "--port") == 0) {
+            opts.vrpn_port = std::atoi(value());
+        } else if (std::strcmp(arg, "--receivers") == 0) {
+            opts.receivers = std::max(1, std::atoi(value()));
+        } else if (std::strcmp(arg, "--sender-rate") == 0) {
+            opts.sender_rate_hz = std::atof(value());
+        } else if (std::strcmp(arg, "--rate") == 0) {
+            opts.receiver_rate_hz = std::atof(value());
+        } else if (std::strcmp(arg, "--warmup") == 0) {
+            opts.warmup_s = std::atof(value());
+        } else if (std::strcmp(arg, "--duration") == 0) {
+            opts.duration_s = std::atof(value());
+        } else if (std::strcmp(arg, "--min-rate-ratio") == 0) {
+            opts.min_rate_ratio = std::atof(value());
+        } else if (std::strcmp(arg, "--max-loss") == 0) {
+            opts.max_loss_ratio = std::atof(value());
+        } else if (std::strcmp(arg, "--max-duplicates") == 0) {
+            opts.max_duplicate_ratio = std::atof(value());
+        } else if (std::strcmp(arg, "--max-p99-latency-ms") == 0) {
+            opts.max_p99_latency_ms = std::atof(value());
+        } else if (std::strcmp(arg, "--shm") == 0) {
+            opts.shm_name = value();
+        } else if (std::strcmp(arg, "--control") == 0) {
+            opts.control = true;
+        } else if (std::strcmp(arg, "--verbose") == 0) {
+            opts.verbose = true;
+        } else if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            std::exit(2);
+        }
+    }
+    return opts;
+}
+
+pid_t spawn(const std::vector<std::string>& args, bool verbose) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (!verbose) {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+    pid_t pid       = -1;
+    const int rc    = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (rc != 0) {
+        std::fprintf(stderr, "[loopback] failed to start %s: %s\n", argv[0], std::strerror(rc));
+        return -1;
+    }
+    return pid;
+}
+
+// Returns true if the child is still running (it should be, until we stop it).
+bool still_running(pid_t pid) {
+    int status = 0;
+    return ::waitpid(pid, &status, WNOHANG) == 0;
+}
+
+void stop(pid_t pid) {
+    if (pid <= 0) {
+        return;
+    }
+    ::kill(pid, SIGTERM);
+    for (int i = 0; i < 50; ++i) {
+        int status = 0;
+        if (::waitpid(pid, &status, WNOHANG) != 0) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+}
+
+bool open_sink(Sink& sink) {
+    sink.socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (sink.socket < 0) {
+        return false;
+    }
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len        = sizeof(addr);
+    if (::bind(sink.socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::getsockname(sink.socket, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        return false;
+    }
+    sink.port = ntohs(addr.sin_port);
+    return true;
+}
+
+void consume(Sink& sink, const uint8_t* data, size_t length, double arrival_us, bool measuring) {
+    for (size_t i = 0; i < length; ++i) {
+        mavlink_message_t message{};
+        mavlink_status_t status{};
+        const uint8_t result = mavlink_frame_char_buffer(&sink.rx_message, &sink.rx_status, data[i], &message, &status);
+        if (result == MAVLINK_FRAMING_BAD_CRC) {
+            sink.crc_errors += measuring ? 1 : 0;
+            continue;
+        }
+        if (result != MAVLINK_FRAMING_OK || message.msgid != MAVLINK_MSG_ID_VISION_POSITION_ESTIMATE) {
+            continue;
+        }
+
+        Stream& stream      = sink.streams[message.sysid];
+        const uint64_t usec = mavlink_msg_vision_position_estimate_get_usec(&message);
+        if (measuring) {
+            stream.stats.frames += 1;
+            if (stream.have_seq) {
+                stream.stats.lost += static_cast<uint8_t>(message.seq - stream.last_seq - 1);
+            }
+            if (usec == stream.last_usec) {
+                stream.stats.duplicates += 1;
+            }
+            stream.stats.latency_ms.push_back((arrival_us - static_cast<double>(usec)) / 1000.0);
+        }
+        stream.have_seq  = true;
+        stream.last_seq  = message.seq;
+        stream.last_usec = usec;
+    }
+}
+
+// Sends one command line to a receiver's control socket and returns the whole reply, or "" if the
+// socket could not be reached. Half-closing after the command makes the receiver close once it
+// has answered.
+std::string control_command(const std::string& path, const std::string& line) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return "";
+    }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string reply;
+    const std::string command = line + "\n";
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+        ::send(fd, command.data(), command.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(command.size()) &&
+        ::shutdown(fd, SHUT_WR) == 0) {
+        char buffer[512];
+        ssize_t length = 0;
+        while ((length = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            reply.append(buffer, static_cast<size_t>(length));
+        }
+    }
+    ::close(fd);
+    return reply;
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options opts = parse_args(argc, argv);
+
+    std::vector<Sink> sinks(static_cast<size_t>(opts.receivers));
+    for (auto& sink : sinks) {
+        if (!open_sink(sink)) {
+            std::fprintf(stderr, "[loopback] cannot open UDP sink: %s\n", std::strerror(errno));
+            return 2;
+        }
+    }
+
+    const std::string port = std::to_string(opts.vrpn_port);
+    std::printf("[loopback] starting sender on :%s\n", port.c_str());
+    std::vector<std::string> sender_args = {opts.sender_bin,
+                                            "--bind",
+                                            ":" + port,
+                                            "--num-trackers",
+                                            std::to_string(opts.receivers + (opts.control ? 1 : 0)),
+                                            "--rate",
+                                            std::to_string(opts.sender_rate_hz),
+                                            "--status-interval",
+                                            "0",
+                                            "--quiet"};
+    if (!opts.shm_name.empty()) {
+        sender_args.insert(sender_args.end(), {"--shm", opts.shm_name});
+    }
+    const pid_t sender = spawn(sender_args, opts.verbose);
+    if (sender < 0) {
+        return 2;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    const std::string control_path = "/tmp/vrpn_loopback_control_" + std::to_string(::getpid()) + ".sock";
+    std::vector<pid_t> receivers;
+    for (int i = 0; i < opts.receivers; ++i) {
+        const auto& sink = sinks[static_cast<size_t>(i)];
+        std::vector<std::string> receiver_args = {opts.receiver_bin,
+                                                  "--tracker",
+                                                  "uav" + std::to_string(i),
+                                                  "--host",
+                                                  "127.0.0.1",
+                                                  "--port",
+                                                  port,
+                                                  "--link",
+                                                  "udp",
+                                                  "--udp-target",
+                                                  "127.0.0.1:" + std::to_string(sink.port),
+                                                  "--rate",
+                                                  std::to_string(opts.receiver_rate_hz),
+                                                  "--sysid",
+                                                  std::to_string(i + 1)};
+        if (!opts.shm_name.empty()) {
+            receiver_args.insert(receiver_args.end(), {"--shm", opts.shm_name});
+        }
+        if (opts.control && i == 0) {
+            receiver_args.insert(receiver_args.end(), {"--control", control_path});
+        }
+        receivers.push_back(spawn(receiver_args, opts.verbose));
+    }
+
+    using clock            = std::chrono::steady_clock;
+    const auto start       = clock::now();
+    const auto measure_at  = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(opts.warmup_s));
+    const auto end         = measure_at + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(opts.duration_s));
+
+    // --control: the extra tracker joins sink 0's link, leaves it and joins again while measuring.
+    const std::string added_tracker = "uav" + std::to_string(opts.receivers);
+    const uint8_t added_sysid       = static_cast<uint8_t>(opts.receivers + 1);
+    const std::vector<std::pair<double, std::string>> commands = {
+        {0.2, "add " + added_tracker + " " + std::to_string(added_sysid)},
+        {0.5, "remove " + added_tracker},
+        {0.7, "add " + added_tracker + " " + std::to_string(added_sysid)}};
+    size_t next_command = 0;
+    bool commands_ok    = true;
+    clock::time_point removed_at{};
+    clock::time_point readded_at{};
+    uint64_t frames_at_remove = 0;
+    uint64_t frames_at_readd  = 0;
+    auto added_frames         = [&]() {
+        const auto it = sinks.front().streams.find(added_sysid);
+        return it == sinks.front().streams.end() ? uint64_t{0} : it->second.stats.frames;
+    };
+
+    std::vector<pollfd> fds;
+    for (const auto& sink : sinks) {
+        fds.push_back({sink.socket, POLLIN, 0});
+    }
+    uint8_t buffer[2048];
+    while (clock::now() < end) {
+        if (opts.control && next_command < commands.size() &&
+            clock::now() >= measure_at + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(
+                                             commands[next_command].first * opts.duration_s))) {
+            const std::string& line  = commands[next_command].second;
+            const std::string reply  = control_command(control_path, line);
+            const bool ok            = reply.compare(0, 3, "ok ") == 0;
+            commands_ok              = commands_ok && ok;
+            std::printf("[loopback] control: %s -> %s", line.c_str(), reply.empty() ? "no reply\n" : reply.c_str());
+            if (next_command == 1) {
+                removed_at       = clock::now();
+                frames_at_remove = added_frames();
+            } else if (next_command == 2) {
+                readded_at      = clock::now();
+                frames_at_readd = added_frames();
+            }
+            ++next_command;
+        }
+        // Frames already on their way when `remove` was answered are allowed for a short while.
+        if (opts.control && next_command == 2 && clock::now() < removed_at + std::chrono::milliseconds(200)) {
+            frames_at_remove = added_frames();
+        }
+        if (::poll(fds.data(), fds.size(), 50) <= 0) {
+            continue;
+        }
+        const bool measuring = clock::now() >= measure_at;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            const ssize_t n = ::recv(sinks[i].socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (n > 0) {
+                consume(sinks[i], buffer, static_cast<size_t>(n), wall_clock_us(), measuring);
+            }
+        }
+    }
+
+    bool processes_ok = still_running(sender);
+    for (pid_t pid : receivers) {
+        processes_ok = processes_ok && pid > 0 && still_running(pid);
+    }
+    for (pid_t pid : receivers) {
+        stop(pid);
+    }
+    stop(sender);
+
+    bool pass = processes_ok;
+    if (!processes_ok) {
+        std::printf("[loopback] FAIL: a sender or receiver exited early\n");
+    }
+    for (size_t i = 0; i < sinks.size(); ++i) {
+        const auto& stats      = sinks[i].streams[static_cast<uint8_t>(i + 1)].stats;
+        const double rate      = stats.frames / opts.duration_s;
+        const bool rate_ok     = rate >= opts.min_rate_ratio * opts.receiver_rate_hz;
+        const double sent      = static_cast<double>(stats.frames + stats.lost);
+        const double loss      = sent > 0.0 ? stats.lost / sent : 1.0;
+        const double dup_ratio = stats.frames > 0 ? static_cast<double>(stats.duplicates) / stats.frames : 0.0;
+        const double p50       = percentile(stats.latency_ms, 0.5);
+        const double p99       = percentile(stats.latency_ms, 0.99);
+        const bool ok          = rate_ok && loss <= opts.max_loss_ratio && dup_ratio <= opts.max_duplicate_ratio &&
+                        p99 <= opts.max_p99_latency_ms && sinks[i].crc_errors == 0;
+        pass = pass && ok;
+        std::printf("[loopback] uav%zu: %s rate=%.1f/%.1f Hz frames=%llu lost=%llu (%.2f%%) dup=%llu (%.2f%%) "
+                    "crc_err=%llu latency ms p50=%.2f p99=%.2f max=%.2f\n",
+                    i,
+                    ok ? "PASS" : "FAIL",
+                    rate,
+                    opts.receiver_rate_hz,
+                    static_cast<unsigned long long>(stats.frames),
+                    static_cast<unsigned long long>(stats.lost),
+                    loss * 100.0,
+                    static_cast<unsigned long long>(stats.duplicates),
+                    dup_ratio * 100.0,
+                    static_cast<unsigned long long>(sinks[i].crc_errors),
+                    p50,
+                    p99,
+                    percentile(stats.latency_ms, 1.0));
+    }
+    if (opts.control) {
+        // Sequence numbers carry on across remove and re-add, so any gap is a lost or renumbered frame.
+        const auto& added           = sinks.front().streams[added_sysid].stats;
+        const uint64_t while_gone   = readded_at > removed_at ? frames_at_readd - frames_at_remove : 1;
+        const bool ok               = commands_ok && next_command == commands.size() && frames_at_remove > 0 &&
+                        added.frames > frames_at_readd && added.lost == 0 && while_gone == 0;
+        pass = pass && ok;
+        std::printf("[loopback] %s (sysid %u) via control socket: %s frames=%llu lost=%llu while_removed=%llu\n",
+                    added_tracker.c_str(),
+                    static_cast<unsigned>(added_sysid),
+                    ok ? "PASS" : "FAIL",
+                    static_cast<unsigned long long>(added.frames),
+                    static_cast<unsigned long long>(added.lost),
+                    static_cast<unsigned long long>(while_gone));
+    }
+    for (auto& sink : sinks) {
+        ::close(sink.socket);
+    }
+    std::printf("[loopback] %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,448 @@
+// Checks of the bridge's pure building blocks: no sockets, no VRPN server and no sleeping; time is
+// passed in where it matters, so they run quickly and fail deterministically. The shared-memory
+// source runs against a real segment named after the test's pid. End-to-end behaviour
+// is covered by loopback_harness and fc_emulator.
+
+#include "receiver/FrameTransform.h"
+#include "receiver/LinkScheduler.h"
+#include "receiver/RedundantPoseSource.h"
+#include "receiver/ShmPoseSource.h"
+#include "receiver/VehicleRoster.h"
+#include "vrpn_common/SharedPoseTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                           \
+    do {                                                                           \
+        if (!(condition)) {                                                        \
+            std::printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition);     \
+            ++g_failures;                                                          \
+        }                                                                          \
+    } while (0)
+
+bool near(double a, double b, double tolerance = 1e-9) {
+    return std::fabs(a - b) <= tolerance;
+}
+
+template <typename Fn>
+bool throws(Fn&& fn) {
+    try {
+        fn();
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+receiver::Pose transform_one(const receiver::FrameTransformOptions& options, const receiver::Pose& in) {
+    receiver::FrameTransformStage stage;
+    stage.add_tracker(options);
+    receiver::PoseBatch batch;
+    batch.resize(stage.size());
+    batch.set(0, in);
+    stage.apply(batch);
+    return batch.get(0);
+}
+
+receiver::Pose pose_at(double x, double y, double z, double qx = 0.0, double qy = 0.0, double qz = 0.0,
+                       double qw = 1.0) {
+    receiver::Pose pose;
+    pose.x  = x;
+    pose.y  = y;
+    pose.z  = z;
+    pose.qx = qx;
+    pose.qy = qy;
+    pose.qz = qz;
+    pose.qw = qw;
+    return pose;
+}
+
+void test_parse_vector3() {
+    std::printf("parse_vector3\n");
+    const auto v = receiver::parse_vector3("1,-2.5,3e-1");
+    CHECK(near(v[0], 1.0) && near(v[1], -2.5) && near(v[2], 0.3));
+    CHECK(throws([] { receiver::parse_vector3("1,2,3,4"); }));
+    CHECK(throws([] { receiver::parse_vector3("1,2,3,"); }));
+    CHECK(throws([] { receiver::parse_vector3("1,2"); }));
+    CHECK(throws([] { receiver::parse_vector3("1,,3"); }));
+    CHECK(throws([] { receiver::parse_vector3("1,2,3m"); }));
+}
+
+void test_frame_transform() {
+    std::printf("frame transform\n");
+    const double half = std::sqrt(0.5);
+
+    receiver::FrameTransformOptions enu;
+    enu.frame = receiver::MocapFrame::kEnu;
+    // ENU (east, north, up) = (1, 2, 3) is NED (2, 1, -3). An unrotated FLU body faces east: yaw +90°.
+    auto out = transform_one(enu, pose_at(1.0, 2.0, 3.0));
+    CHECK(near(out.x, 2.0) && near(out.y, 1.0) && near(out.z, -3.0));
+    CHECK(near(out.roll, 0.0) && near(out.pitch, 0.0) && near(out.yaw, M_PI / 2.0));
+    // Turned +90° about up, it faces north: yaw 0.
+    out = transform_one(enu, pose_at(0.0, 0.0, 0.0, 0.0, 0.0, half, half));
+    CHECK(near(out.roll, 0.0) && near(out.pitch, 0.0) && near(out.yaw, 0.0));
+    // Nose pitched up 30° while facing east (negative rotation about FLU left = ENU north).
+    const double pitch = M_PI / 6.0;
+    out = transform_one(enu, pose_at(0.0, 0.0, 0.0, 0.0, -std::sin(pitch / 2.0), 0.0, std::cos(pitch / 2.0)));
+    CHECK(near(out.pitch, pitch) && near(out.roll, 0.0) && near(out.yaw, M_PI / 2.0));
+
+    receiver::FrameTransformOptions yup;
+    yup.frame = receiver::MocapFrame::kYUp;
+    // Y-up (right = east, up, back = south) = (1, 2, 3) is NED (-3, 1, -2); unrotated faces north.
+    out = transform_one(yup, pose_at(1.0, 2.0, 3.0));
+    CHECK(near(out.x, -3.0) && near(out.y, 1.0) && near(out.z, -2.0));
+    CHECK(near(out.roll, 0.0) && near(out.pitch, 0.0) && near(out.yaw, 0.0));
+    // +90° about Y-up turns the nose from -Z (north) to -X (west): yaw -90°.
+    out = transform_one(yup, pose_at(0.0, 0.0, 0.0, 0.0, half, 0.0, half));
+    CHECK(near(out.roll, 0.0) && near(out.pitch, 0.0) && near(out.yaw, -M_PI / 2.0));
+
+    // Yaw offset and origin offset compose after the frame change.
+    yup.yaw_offset_rad = M_PI / 2.0;
+    yup.origin_offset  = {10.0, 0.0, 0.0};
+    out = transform_one(yup, pose_at(0.0, 0.0, -1.0));  // 1 m mocap-north
+    CHECK(near(out.x, 10.0) && near(out.y, 1.0) && near(out.z, 0.0));
+    CHECK(near(out.yaw, M_PI / 2.0));
+}
+
+void test_body_offset() {
+    std::printf("body offset\n");
+    const double half = std::sqrt(0.5);
+
+    // Yawed +90° the body's forward axis points east, so 1 m forward of the pivot is 1 m east.
+    receiver::FrameTransformOptions ned;
+    ned.body_offset = {1.0, 0.0, 0.0};
+    auto out        = transform_one(ned, pose_at(1.0, 2.0, 3.0, 0.0, 0.0, half, half));
+    CHECK(near(out.x, 1.0) && near(out.y, 3.0) && near(out.z, 3.0));
+    CHECK(near(out.yaw, M_PI / 2.0));
+    // Rolled +90° (right wing down) the body's right axis points down.
+    ned.body_offset = {0.0, 2.0, 0.0};
+    out             = transform_one(ned, pose_at(1.0, 2.0, 3.0, half, 0.0, 0.0, half));
+    CHECK(near(out.x, 1.0) && near(out.y, 2.0) && near(out.z, 5.0));
+
+    // In ENU the offset is still FRD of the converted attitude: the unrotated body faces east, so
+    // 1 m forward and 0.5 m down is NED (0, 1, 0.5) on top of the converted position (2, 1, -3).
+    receiver::FrameTransformOptions enu;
+    enu.frame       = receiver::MocapFrame::kEnu;
+    enu.body_offset = {1.0, 0.0, 0.5};
+    out             = transform_one(enu, pose_at(1.0, 2.0, 3.0));
+    CHECK(near(out.x, 2.0) && near(out.y, 2.0) && near(out.z, -2.5));
+    // Pitched nose-up 90° (facing east) forward points up: 2 m forward is NED (0, 0, -2).
+    enu.body_offset    = {2.0, 0.0, 0.0};
+    const double pitch = M_PI / 2.0;
+    out = transform_one(enu, pose_at(1.0, 2.0, 3.0, 0.0, -std::sin(pitch / 2.0), 0.0, std::cos(pitch / 2.0)));
+    CHECK(near(out.x, 2.0) && near(out.y, 1.0) && near(out.z, -5.0));
+}
+
+void test_link_scheduler() {
+    std::printf("link scheduler\n");
+    // 1000 B/s of 10-byte frames carries 100 frames/s.
+    receiver::LinkScheduler scheduler(1000.0, 10.0);
+    const size_t slow  = scheduler.add_vehicle(20.0, 1.0);
+    const size_t fast  = scheduler.add_vehicle(100.0, 1.0);
+    const size_t heavy = scheduler.add_vehicle(100.0, 2.0);
+    CHECK(near(scheduler.capacity_hz(), 100.0));
+
+    // A frame the link dropped uses the slot but is not counted as sent, and its size does not
+    // move the frame average the budget is split with.
+    const auto now = receiver::LinkScheduler::clock::now();
+    scheduler.advance(now);
+    scheduler.advance(now + std::chrono::milliseconds(10));
+    CHECK(scheduler.acquire(slow));
+    scheduler.commit(slow, 0);
+    CHECK(scheduler.vehicle(slow).sent == 0 && scheduler.vehicle(slow).dropped == 1);
+    CHECK(!scheduler.due(slow));
+    CHECK(near(scheduler.capacity_hz(), 100.0));
+    scheduler.advance(now + std::chrono::milliseconds(20));  // the link bucket holds one frame
+    CHECK(scheduler.acquire(fast));
+    scheduler.commit(fast, 10);
+    CHECK(scheduler.vehicle(fast).sent == 1 && scheduler.vehicle(fast).dropped == 0);
+
+    // First pass: 25 Hz per unit weight; `slow` wants less and keeps 20. The other 80 split 1:2.
+    CHECK(near(scheduler.vehicle(slow).allocated_hz, 20.0));
+    CHECK(near(scheduler.vehicle(fast).allocated_hz, 80.0 / 3.0));
+    CHECK(near(scheduler.vehicle(heavy).allocated_hz, 160.0 / 3.0));
+
+    // A paused (stale) vehicle gives its share back and gets it again on resume.
+    scheduler.set_paused(heavy, true);
+    CHECK(near(scheduler.vehicle(heavy).allocated_hz, 0.0));
+    CHECK(near(scheduler.vehicle(fast).allocated_hz, 80.0));
+    scheduler.set_paused(heavy, false);
+    CHECK(near(scheduler.vehicle(fast).allocated_hz, 80.0 / 3.0));
+
+    // Removing frees the slot for the next vehicle and re-splits between the rest.
+    scheduler.remove_vehicle(fast);
+    CHECK(!scheduler.active(fast));
+    CHECK(!scheduler.due(fast));
+    CHECK(near(scheduler.vehicle(heavy).allocated_hz, 80.0));
+    CHECK(scheduler.add_vehicle(10.0, 1.0) == fast);
+    CHECK(scheduler.size() == 3);
+    CHECK(near(scheduler.vehicle(fast).allocated_hz, 10.0));
+    CHECK(near(scheduler.vehicle(heavy).allocated_hz, 70.0));
+
+    scheduler.set_rate(slow, 200.0);
+    // 100 Hz over weights 1 + 1 + 2: `fast` keeps its 10, the other 90 split 1:2.
+    CHECK(near(scheduler.vehicle(slow).allocated_hz, 30.0));
+    CHECK(near(scheduler.vehicle(heavy).allocated_hz, 60.0));
+
+    // Without a budget every vehicle gets what it asks for.
+    receiver::LinkScheduler unlimited(0.0, 10.0);
+    const size_t only = unlimited.add_vehicle(250.0, 1.0);
+    CHECK(!unlimited.limited());
+    CHECK(near(unlimited.vehicle(only).allocated_hz, 250.0));
+}
+
+// A source the test feeds by hand: deliver() is one new sample, stamped with the arrival time
+// RedundantPoseSource would otherwise take from the network.
+class FakeSource : public receiver::PoseSource {
+public:
+    void deliver(double timestamp_sec, clock::time_point arrival) {
+        receiver::Pose pose;
+        pose.timestamp_sec = timestamp_sec;
+        pose_              = pose;
+        arrival_           = arrival;
+    }
+
+    bool spin_once() override { return live; }
+    std::optional<receiver::Pose> latest_pose() const override { return pose_; }
+    clock::time_point last_pose_time() const override { return arrival_; }
+    const receiver::TrackerStats& stats() const override { return stats_; }
+    void set_capture(receiver::CaptureWriter*) override {}
+
+    bool live = true;
+
+private:
+    std::optional<receiver::Pose> pose_;
+    clock::time_point arrival_{};
+    receiver::TrackerStats stats_{};
+};
+
+void test_redundant_source() {
+    std::printf("redundant source\n");
+    using clock = receiver::PoseSource::clock;
+    auto primary_owned = std::make_unique<FakeSource>();
+    auto backup_owned  = std::make_unique<FakeSource>();
+    FakeSource& primary = *primary_owned;
+    FakeSource& backup  = *backup_owned;
+    std::vector<std::unique_ptr<receiver::PoseSource>> sources;
+    sources.push_back(std::move(primary_owned));
+    sources.push_back(std::move(backup_owned));
+    receiver::RedundantPoseSource redundant(std::move(sources), 0.005);
+
+    // Every arrival and spin is on a made-up timeline 1 ms apart, so only the tolerance decides.
+    auto now  = clock::now();
+    auto tick = [&]() { return now += std::chrono::milliseconds(1); };
+
+    // Both servers carry every frame, one spin apart, and which one is first alternates. The backup
+    // being first must not pull the output over: the primary matches it well within tolerance.
+    double stamp = 100.0;
+    for (int frame = 0; frame < 20; ++frame, stamp += 0.01) {
+        FakeSource& first  = frame % 2 ? backup : primary;
+        FakeSource& second = frame % 2 ? primary : backup;
+        first.deliver(stamp, tick());
+        redundant.spin_once(now);
+        second.deliver(stamp, tick());
+        redundant.spin_once(now);
+        CHECK(redundant.latest_pose() && near(redundant.latest_pose()->timestamp_sec, stamp));
+    }
+    CHECK(redundant.active() == 0);
+    CHECK(redundant.switches() == 0);
+    CHECK(redundant.stats().poses == 20);
+    CHECK(redundant.source_stats(0).selected == 20);
+
+    // The primary stays connected but stops delivering. The backup's sample is held until the
+    // tolerance has passed since its arrival, then forwarded.
+    const auto held_at = tick();
+    backup.deliver(stamp, held_at);
+    redundant.spin_once(held_at);
+    redundant.spin_once(held_at + std::chrono::microseconds(4999));
+    CHECK(redundant.active() == 0);
+    CHECK(redundant.stats().poses == 20);
+    now = held_at + std::chrono::milliseconds(5);
+    redundant.spin_once(now);
+    CHECK(redundant.active() == 1);
+    CHECK(redundant.switches() == 1);
+    CHECK(near(redundant.latest_pose()->timestamp_sec, stamp));
+    stamp += 0.01;
+
+    // The primary comes back with current data and takes over again on its first sample.
+    primary.deliver(stamp, tick());
+    redundant.spin_once(now);
+    CHECK(redundant.active() == 0);
+    CHECK(redundant.switches() == 2);
+    backup.deliver(stamp, tick());
+    redundant.spin_once(now);
+    CHECK(redundant.active() == 0);
+    stamp += 0.01;
+
+    // A disconnected active source is not waited for.
+    primary.live = false;
+    backup.deliver(stamp, tick());
+    redundant.spin_once(now);
+    CHECK(redundant.active() == 1);
+    CHECK(redundant.switches() == 3);
+    CHECK(near(redundant.latest_pose()->timestamp_sec, stamp));
+}
+
+void publish_sample(vrpn_common::SharedPoseWriter& writer, size_t slot, double x) {
+    const double pos[3]  = {x, 0.0, 0.0};
+    const double quat[4] = {0.0, 0.0, 0.0, 1.0};
+    writer.publish(slot, 1700000000, 0, pos, quat);
+}
+
+void test_shm_source_restart() {
+    std::printf("shm source restart\n");
+    using clock               = receiver::PoseSource::clock;
+    const std::string segment = "/vrpn_unit_" + std::to_string(::getpid());
+    auto writer = std::make_unique<vrpn_common::SharedPoseWriter>(segment, std::vector<std::string>{"uav0"});
+
+    bool refused = false;
+    try {
+        receiver::ShmPoseSource missing(segment, "uav1");
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    CHECK(refused);
+
+    receiver::ShmPoseSource source(segment, "uav0");
+    const auto start = clock::now();
+    publish_sample(*writer, 0, 1.0);
+    CHECK(source.spin_once(start));
+    CHECK(source.latest_pose() && near(source.latest_pose()->x, 1.0));
+
+    // The sender restarts without uav0. Once the slot has gone quiet the source notices the new
+    // segment, and from then on retries instead of throwing out of the polling thread.
+    writer.reset();
+    writer = std::make_unique<vrpn_common::SharedPoseWriter>(segment, std::vector<std::string>{"uav1"});
+    CHECK(!source.spin_once(start + std::chrono::seconds(1)));
+    CHECK(source.stats().disconnects == 1);
+    bool retried = true;
+    try {
+        retried = !source.spin_once(start + std::chrono::milliseconds(1001));
+    } catch (const std::exception&) {
+        retried = false;
+    }
+    CHECK(retried);
+    CHECK(source.stats().reconnect_attempts == 1);
+    CHECK(!source.spin_once(start + std::chrono::milliseconds(1002)));  // waits for the retry period
+    CHECK(source.stats().reconnect_attempts == 1);
+
+    // It comes back with uav0 in another slot.
+    writer.reset();
+    writer = std::make_unique<vrpn_common::SharedPoseWriter>(segment, std::vector<std::string>{"uav1", "uav0"});
+    publish_sample(*writer, 1, 2.0);
+    CHECK(source.spin_once(start + std::chrono::seconds(2)));
+    CHECK(source.stats().reconnect_attempts == 2);
+    CHECK(source.latest_pose() && near(source.latest_pose()->x, 2.0));
+}
+
+bool starts_with(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+void test_vehicle_roster_parsing() {
+    std::printf("vehicle roster parsing\n");
+    const auto spec = receiver::parse_vehicle_spec("uav3:7:2.5");
+    CHECK(spec.tracker == "uav3" && spec.system_id == 7 && near(spec.weight, 2.5));
+    CHECK(near(receiver::parse_vehicle_spec("uav0:1").weight, 1.0));
+    CHECK(throws([] { receiver::parse_vehicle_spec("uav0"); }));
+    CHECK(throws([] { receiver::parse_vehicle_spec(":1"); }));
+    CHECK(throws([] { receiver::parse_vehicle_spec("uav0:1x"); }));
+    CHECK(throws([] { receiver::parse_vehicle_spec("uav0:256"); }));
+    CHECK(throws([] { receiver::parse_vehicle_spec("uav0:1:w"); }));
+    CHECK(receiver::parse_system_id("255") == 255);
+    CHECK(throws([] { receiver::parse_system_id("0"); }));
+    CHECK(throws([] { receiver::parse_system_id("1.5"); }));
+    CHECK(throws([] { receiver::parse_number("50abc", "rate"); }));
+    CHECK(throws([] { receiver::parse_number("", "rate"); }));
+}
+
+void test_vehicle_roster_commands() {
+    std::printf("vehicle roster commands\n");
+    receiver::LinkScheduler scheduler(0.0, 40.0);
+    std::vector<std::string> attached;  // what the bridge would hold per slot
+    bool refuse = false;
+    receiver::VehicleRoster::Hooks hooks;
+    hooks.added = [&](size_t slot, const receiver::VehicleSpec& spec) {
+        if (refuse) {
+            throw std::runtime_error(spec.tracker + " is not published");
+        }
+        attached.resize(std::max(attached.size(), slot + 1));
+        attached[slot] = spec.tracker;
+    };
+    hooks.removed = [&](size_t slot) { attached[slot].clear(); };
+    receiver::VehicleRoster roster(scheduler, 50.0, hooks);
+
+    CHECK(roster.add({"uav0", 1, 1.0}, 50.0) == 0);
+    CHECK(starts_with(roster.handle("add uav1 2"), "ok uav0 50.0 Hz, uav1 50.0 Hz"));
+    CHECK(starts_with(roster.handle("add uav2 3 2 25"), "ok "));
+    CHECK(roster.size() == 3 && attached.size() == 3);
+    CHECK(near(scheduler.vehicle(2).requested_hz, 25.0) && near(scheduler.vehicle(2).weight, 2.0));
+
+    // Names and system IDs stay unique among live vehicles; a refused add changes nothing.
+    CHECK(starts_with(roster.handle("add uav1 9"), "error: uav1 is already forwarded"));
+    CHECK(starts_with(roster.handle("add uav9 2"), "error: sysid 2 is already used by uav1"));
+    CHECK(starts_with(roster.handle("sysid uav2 1"), "error: sysid 1 is already used by uav0"));
+    CHECK(starts_with(roster.handle("sysid uav2 3"), "ok "));
+    CHECK(throws([&] { roster.add({"uav5", 1, 1.0}, 50.0); }));
+    CHECK(roster.size() == 3);
+
+    // Removing frees the slot, its sysid and its name; the next add reuses all three.
+    CHECK(starts_with(roster.handle("remove uav1"), "ok uav0 50.0 Hz, uav2 25.0 Hz"));
+    CHECK(!roster.active(1) && !scheduler.active(1) && attached[1].empty());
+    CHECK(starts_with(roster.handle("remove uav1"), "error: uav1 is not forwarded"));
+    CHECK(starts_with(roster.handle("add uav4 2"), "ok "));
+    CHECK(roster.find("uav4") == 1 && attached[1] == "uav4" && roster.size() == 3);
+    CHECK(roster.spec(1).system_id == 2);
+
+    // A vehicle the bridge cannot open is refused and its slot handed back.
+    refuse = true;
+    CHECK(starts_with(roster.handle("add uav7 8"), "error: uav7 is not published"));
+    CHECK(scheduler.size() == 4 && !scheduler.active(3) && !roster.active(3));
+    refuse = false;
+    CHECK(starts_with(roster.handle("add uav7 8"), "ok "));
+    CHECK(roster.find("uav7") == 3);
+
+    // `rate all` changes every live vehicle and the default for later adds.
+    CHECK(starts_with(roster.handle("rate all 20"), "ok "));
+    CHECK(near(roster.default_rate_hz(), 20.0) && near(scheduler.vehicle(0).requested_hz, 20.0));
+    CHECK(starts_with(roster.handle("rate uav0 0"), "error: rate must be positive"));
+    CHECK(starts_with(roster.handle("rate uav0 fast"), "error: bad rate 'fast'"));
+
+    // Malformed lines are errors, and stats lists every live vehicle.
+    CHECK(starts_with(roster.handle("add uav8"), "error: cannot parse"));
+    CHECK(starts_with(roster.handle("frobnicate"), "error: cannot parse"));
+    const std::string stats = roster.handle("stats");
+    CHECK(stats.find("uav4 sysid=2") != std::string::npos && stats.find("uav1") == std::string::npos);
+    CHECK(stats.size() >= 3 && stats.compare(stats.size() - 3, 3, "ok\n") == 0);
+}
+
+}  // namespace
+
+int main() {
+    test_parse_vector3();
+    test_frame_transform();
+    test_body_offset();
+    test_link_scheduler();
+    test_redundant_source();
+    test_shm_source_restart();
+    test_vehicle_roster_parsing();
+    test_vehicle_roster_commands();
+
+    if (g_failures != 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}